@@ -1,4 +1,19 @@
 #include "4inARow.h"
+#include <stdlib.h>
+#include <string.h>
+#include "bitboard.h"
+#include "solver.h"
+#include "bookBuilder.h"
+#include "perft.h"
+#include "bulkValidator.h"
+#include "record.h"
+#include "codec.h"
+#include "tournament.h"
+#include "server.h"
+#include "gameFile.h"
+#include "boardStats.h"
+#include "generator.h"
+#include "instrument.h"
 
 /**
  * @brief Convert a character representing a player to its integer equivalent
@@ -31,7 +46,7 @@ char getPlayerAsChar(int player) {
  * @param rows Number of rows in the board
  * @param columns Number of columns in the board
  */
-void initBoard(char board[ROWS][COLS], int rows, int columns) {
+void initBoard(char board[MAX_ROWS][MAX_COLS], int rows, int columns) {
     
     // Loop over each row
     for (int i = 0; i < rows; i++) {
@@ -53,7 +68,7 @@ void initBoard(char board[ROWS][COLS], int rows, int columns) {
  * @param rows Number of rows in the board
  * @param columns Number of columns in the board
  */
-void printBoard(char board[ROWS][COLS], int rows, int columns) {
+void printBoard(char board[MAX_ROWS][MAX_COLS], int rows, int columns) {
     
     // Loop over each row including top and bottom borders
     for (int i = 0; i < rows + 2; i++) {
@@ -82,260 +97,319 @@ void printBoard(char board[ROWS][COLS], int rows, int columns) {
 /**
  * @brief Check if a given board state is valid
  * 
- * This function performs two main validations:
- * 1. Checks for invalid wins (e.g., multiple separate wins for the same player or
- *    wins with illegal placements).
- * 2. Checks for invalid moves or turn order violations.
+ * A board is valid if some legal game, played from the empty board and
+ * stopped at the first win, ends on it:
+ * 1. Every disk belongs to a player and rests on another disk or the floor.
+ * 2. Only the player who moved last may have a connect, and a single disk
+ *    on top of a column must lie on every line of it (the winning move).
+ * 3. The disks can be replayed column by column in turn order.
  * 
- * The board is temporarily encoded to a string and decoded back to preserve state
- * during validation.
+ * The board is never changed, so it can be checked from several threads at
+ * once. The work is linear in the number of disks unless the replay has to
+ * back off, and even then no dead end of the replay is explored twice.
  * 
  * @param board The 2D board array
  * @param rows Number of rows in the board
  * @param columns Number of columns in the board
- * @param players Total number of players
+ * @param players Total number of players, from NUM_PLAYERS to MAX_PLAYERS
  * @param connect Number of disks in a row required to win
- * @return 1 if the board is valid, 0 otherwise
+ * @return 1 if the board is valid, 0 otherwise (also for an unsupported number of players)
  */
-int isValidBoard(char board[ROWS][COLS], int rows, int columns, int players, int connect) {
+int isValidBoard(const char board[MAX_ROWS][MAX_COLS], int rows, int columns, int players, int connect) {
 
-    const int NO_WINS = 0;
-    const int INVALID_WIN = -1;
-    const int MAX_ALLOWED_WINS = 1;
+    PROBE(PROBE_IS_VALID_BOARD);
+    int stacks[MAX_COLS][MAX_ROWS];
+    BoardStats stats;
 
-    // Temporary string to save the board state for restoring later
-    char str[2 * rows * columns + rows + 1];
-    char *code = str;
-    
-    // Encode the board to a string
-    encode(board, rows, columns, code);
-    
-    int validate = 1; // Flag to validate wins strictly
-    int playerWins = 0; // Counter for total wins per player
-    
-    // Validate wins for each player
-    for (int player = 1; player <= players; player++) {
-        int isValidWin = checkForConnect(board, connect, rows, columns, validate, player);
-
-        // If a valid win found, increment the win count
-        if (isValidWin > NO_WINS) {
-            playerWins++;
-            // More than one win for the same player is invalid
-            if (playerWins > MAX_ALLOWED_WINS) {
-                return INVALID_BOARD;
-            }
+    // The statistics are sized for MAX_PLAYERS, and the turn checks divide by players
+    if (players < NUM_PLAYERS || players > MAX_PLAYERS) {
+        return INVALID_BOARD;
+    }
+
+    // One pass over the cells, rejecting floating disks and unknown players
+    getBoardStats(board, rows, columns, players, &stats);
+    if (stats.floating || stats.unknown) {
+        return INVALID_BOARD;
+    }
+
+    // Every player must have played exactly their share of the turns
+    int disks = stats.disks;
+    for (int player = 0; player < players; player++) {
+        if (stats.counts[player] != (disks + players - 1 - player) / players) {
+            return INVALID_BOARD;
+        }
+    }
+
+    if (disks == 0) {
+        return VALID_BOARD;
+    }
+
+    const BitPosition *pos = &stats.pos;
+    int *heights = stats.heights;
+    loadColumnStacks(pos, columns, players, stacks);
+    int lastPlayer = (disks - 1) % players;
+
+    // One pass over the winning windows finds the lines of every player
+    int wins[MAX_PLAYERS];
+    Bitboard shared[MAX_PLAYERS];
+    if (connect == geometry.connect) {
+        countWins(pos, players, wins, shared);
+    } else {
+        for (int player = 0; player < players; player++) {
+            shared[player] = getCommonLineCells(pos->disks[player], connect);
+            wins[player] = shared[player] != 0 || hasConnect(pos->disks[player], connect);
         }
+    }
 
-        // If an invalid win is found, return immediately
-        if (isValidWin == INVALID_WIN) {
+    // Nobody else may have won before the last move
+    for (int player = 0; player < players; player++) {
+        if (player != lastPlayer && wins[player] > 0) {
             return INVALID_BOARD;
         }
     }
 
-    // Restore the board from encoded string
-    decode(code, board);
-    
-    // Validate legal moves and turn order
-    int result = validatePlays(board, rows, columns, players);
-    
-    // Decode back again to restore board state
-    decode(code, board);
-    
-    // Return 1 if board is valid, 0 otherwise
-    return result;
+    if (wins[lastPlayer] == 0) {
+        return canReplayStacks(stacks, heights, columns, players, disks);
+    }
+
+    // The winning disk is on every line and was the last one played
+    Bitboard common = shared[lastPlayer];
+    for (int col = 0; col < columns; col++) {
+        int top = heights[col] - 1;
+
+        if (top < 0 || stacks[col][top] != lastPlayer || !(common & getCellBit(rows - 1 - top, col))) {
+            continue;
+        }
+
+        // Replay everything before the winning disk
+        heights[col]--;
+        int valid = canReplayStacks(stacks, heights, columns, players, disks - 1);
+        heights[col]++;
+
+        if (valid) {
+            return VALID_BOARD;
+        }
+    }
+
+    return INVALID_BOARD;
 }
 
 /**
- * @brief Validate the board in terms of legal player turns and move placements
+ * @brief Check if the column stacks can be played in turn order
  * 
- * This function ensures the board follows the rules of turn order and proper
- * disk placement. It combines two validations:
- * 1. `validatePlayTimes`: Checks that players have played in the correct order
- *    and no player has taken too many turns.
- * 2. `validatePlayMoves`: Checks recursively that all disks are properly
- *    placed without floating disks.
+ * Looks for an order in which the `disks` bottom disks of the columns are
+ * dropped while the players take turns, starting with 'A'. Every state of
+ * the replay is the number of disks dropped in every column, and a state
+ * that leads nowhere is remembered for good. The work is therefore bounded
+ * by the number of states, the product of the column heights plus one,
+ * rather than by the number of orders that lead to them.
  * 
- * @param board The 2D board array
- * @param rows Number of rows in the board
+ * The replay runs both ways: forwards from the empty board, and backwards
+ * from the full stacks by taking the top disks off in reverse turn order.
+ * The two take turns with a step budget that doubles every round, so the
+ * work stays within a small factor of the cheaper direction. When the
+ * longest-run order of `replayStacksWithin` needs no back-off, which is the
+ * usual case, the first round settles it in one step per disk.
+ * 
+ * @param stacks The player index of every disk, bottom first
+ * @param heights Number of disks to replay in every column
  * @param columns Number of columns in the board
- * @param players Total number of players in the game
- * @return 1 if the board is valid, 0 otherwise
+ * @param players Total number of players
+ * @param disks Total number of disks to replay
+ * @return 1 if such an order exists, 0 otherwise (also if memory for the dead ends ran out)
  */
-int validatePlays(char board[ROWS][COLS], int rows, int columns, int players) {
-    
-    // Determine the last player who played and validate turn order
-    int lastPlayed = validatePlayTimes(board, rows, columns, players);
-    
-    // Invalid board if turn order is illegal
-    if (!lastPlayed) {
-        return INVALID_BOARD;
+int canReplayStacks(int stacks[MAX_COLS][MAX_ROWS], const int heights[MAX_COLS], int columns, int players, int disks) {
+
+    PROBE(PROBE_REPLAY_STACKS);
+    int reversed[MAX_COLS][MAX_ROWS];
+    int (*ways[2])[MAX_ROWS] = {stacks, reversed}; // Forwards, then backwards
+    DeadEnds deadEnds[2];
+    int result = REPLAY_UNDECIDED;
+
+    // Backwards, the top disk comes first and the turn order is reversed
+    for (int col = 0; col < columns; col++) {
+        for (int k = 0; k < heights[col]; k++) {
+            int player = stacks[col][heights[col] - 1 - k];
+            reversed[col][k] = ((disks - 1 - player) % players + players) % players;
+        }
     }
-    
-    // Get total number of occupied positions on the board
-    int numOfOccur = getNumOfOccurences(board, rows, columns, EMPTY_POS);
-    
-    // Recursively validate the layout of all moves
-    int res = validatePlayMoves(board, rows, columns, lastPlayed, numOfOccur, players);
-    
-    // Return invalid if layout is incorrect
-    if (!res) {
-        return INVALID_BOARD;
+
+    size_t states = 1;
+    for (int col = 0; col < columns; col++) {
+        states *= (size_t) heights[col] + 1;
+    }
+    for (int way = 0; way < 2; way++) {
+        deadEnds[way].bits = NULL;
+        deadEnds[way].states = states;
+        deadEnds[way].used = 0;
+        memset(deadEnds[way].local, 0, sizeof(deadEnds[way].local));
     }
 
-    // Board is valid if all checks pass
-    return VALID_BOARD;
+    for (long steps = disks + 1; result == REPLAY_UNDECIDED; steps *= 2) {
+        for (int way = 0; way < 2 && result == REPLAY_UNDECIDED; way++) {
+            result = replayStacksWithin(ways[way], heights, columns, players, disks, &deadEnds[way], steps);
+        }
+    }
+
+    for (int way = 0; way < 2; way++) {
+        free(deadEnds[way].bits);
+    }
+
+    return result;
 }
 
 /**
- * @brief Find the column of a player in a given row
+ * @brief Replay the column stacks in turn order within a number of steps
  * 
- * This function searches the specified row for a player's disk.
- * It also detects "floating disks" (disks with empty space below them),
- * which are invalid in games like Connect-style boards.
+ * A depth-first search over the states of the replay. At every turn the
+ * column whose next disks follow the turn order the longest is tried
+ * first. States in `deadEnds` are skipped, and every state found to lead
+ * nowhere is added to it, so a later call with a larger budget carries on
+ * where this one gave up.
  * 
- * @param board The 2D board array
- * @param row The row to check
- * @param columns Total number of columns in the board
- * @param player Player number to search for
- * @param rows Total number of rows in the board (used for bounds checking)
- * @return Column index of the player if found, -1 if not found, -2 if a floating disk is detected
+ * @param stacks The player index of every disk, bottom first
+ * @param heights Number of disks to replay in every column
+ * @param columns Number of columns in the board
+ * @param players Total number of players
+ * @param disks Total number of disks to replay
+ * @param deadEnds The states known to lead nowhere, kept between calls
+ * @param steps Most disks to drop before giving up
+ * @return 1 if such an order exists, 0 if not (or if `deadEnds` could not grow),
+ *         REPLAY_UNDECIDED if the steps ran out
  */
-int getPlayerCol(char board[ROWS][COLS], int row, int columns, int player, int rows) {
-        
-    const int NOT_FOUND = -1;
-    const int FLOATING_DISK = -2;
+int replayStacksWithin(int stacks[MAX_COLS][MAX_ROWS], const int heights[MAX_COLS], int columns, int players, int disks,
+                       DeadEnds *deadEnds, long steps) {
 
-    // Convert player number to character representation
-    char playerAsChar = getPlayerAsChar(player);
-    
-    // Search the row for the player's disk
-    for (int i = 0; i < columns; i++) {
-        // Check for floating disk: non-empty position with empty space directly below
-        if (board[row][i] != EMPTY_POS && row + 1 < rows && board[row + 1][i] == EMPTY_POS) {
-            return FLOATING_DISK;
+    const int NO_COLUMN = -1;
+
+    int runs[MAX_COLS][MAX_ROWS];        // Disks from here on that follow the turn order
+    int next[MAX_COLS] = {0};            // Number of disks already dropped in every column
+    int choice[MAX_MOVES];               // Column played at every turn
+    unsigned tried[MAX_MOVES + 1];       // Columns already tried at every turn
+    uint64_t weights[MAX_COLS];          // Weight of every column in the state number
+    uint64_t state = 0;
+    int turn = 0;
+
+    for (int col = 0; col < columns; col++) {
+        weights[col] = col == 0 ? 1 : weights[col - 1] * (uint64_t) (heights[col - 1] + 1);
+
+        for (int k = heights[col] - 1; k >= 0; k--) {
+            int follows = k + 1 < heights[col] && stacks[col][k + 1] == (stacks[col][k] + 1) % players;
+            runs[col][k] = follows ? runs[col][k + 1] + 1 : 1;
         }
-        
-        // If player's disk found, return its column
-        if (board[row][i] == playerAsChar) {
-            return i;
+    }
+    tried[0] = 0;
+
+    while (turn < disks) {
+        int player = turn % players;
+        int best = NO_COLUMN;
+
+        // Pick the untried column with the longest run in turn order
+        for (int col = 0; col < columns; col++) {
+            if (next[col] < heights[col] && !(tried[turn] & (1u << col)) &&
+                stacks[col][next[col]] == player &&
+                (best == NO_COLUMN || runs[col][next[col]] > runs[best][next[best]])) {
+                best = col;
+            }
+        }
+
+        if (best != NO_COLUMN) {
+            if (steps-- == 0) {
+                return REPLAY_UNDECIDED;
+            }
+            tried[turn] |= 1u << best;
+            choice[turn++] = best;
+            tried[turn] = 0;
+            next[best]++;
+            state += weights[best];
+
+            // Keep going unless this state is a known dead end
+            if (!isDeadEnd(deadEnds, state)) {
+                continue;
+            }
+        } else {
+            // Every column was tried from here
+            if (!addDeadEnd(deadEnds, state) || turn == 0) {
+                return INVALID_BOARD;
+            }
         }
+
+        // Take back the last disk and try another column
+        PROBE_DEPTH(DEPTH_REPLAY, turn);
+        turn--;
+        next[choice[turn]]--;
+        state -= weights[choice[turn]];
     }
-    
-    // Player not found in the row
-    return NOT_FOUND;
-}
 
+    return VALID_BOARD;
+}
 
 /**
- * @brief Recursively validate that all moves on the board are legal
- * 
- * This function ensures that each player's disk is placed correctly:
- * 1. Checks from the last played player down to the first player.
- * 2. Detects floating disks (disks with empty space directly below).
- * 3. Recursively removes validated disks to continue checking previous moves.
- * 
- * @param board The 2D board array
- * @param rows Number of rows in the board
- * @param columns Number of columns in the board
- * @param lastPlayed Last player who made a move
- * @param numOfOccur Total number of disk occurrences left to check
- * @param players Total number of players in the game
- * @return 1 if the board is valid, 0 otherwise
+ * @brief Check if a state of a replay is a known dead end
+ * @param deadEnds The dead ends
+ * @param state The state
+ * @return 1 if the state is stored, 0 otherwise
  */
-int validatePlayMoves(char board[ROWS][COLS], int rows, int columns, int lastPlayed, int numOfOccur, int players) {
-    
-    const int FLOATING_DISK = -2;
-    const int MIN_ROW = 0;
+int isDeadEnd(const DeadEnds *deadEnds, uint64_t state) {
 
-    // Base case: no remaining disks to validate
-    if (numOfOccur == 0) {
-        return VALID_BOARD;
+    const uint64_t HASH_MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+
+    if (deadEnds->bits != NULL) {
+        return (deadEnds->bits[state / 64] >> (state % 64)) & 1;
     }
-    
-    // Iterate over each row to find the last played player's disk
-    for (int i = 0; i < rows; i++) {
-        int playerCol = getPlayerCol(board, i, columns, lastPlayed, rows);
 
-        // Invalid if a floating disk is found
-        if (playerCol == FLOATING_DISK) {
-            return INVALID_BOARD;
-        }
-        
-        // If a valid disk is found
-        if (playerCol >= MIN_ROW) {
-            
-            // Move to the previous player (wrap around if needed)
-            lastPlayed = lastPlayed - 1 == 0 ? players : (lastPlayed - 1);
-            
-            // Ensure no empty space above or it's the first row
-            if ((i != 0 && board[i - 1][playerCol] == EMPTY_POS) || i == 0) {
-                // Clear the current disk for recursive checking
-                board[i][playerCol] = EMPTY_POS;
-                break; // Stop scanning rows for this disk
-            }
-        }
-        
-        // If no player disk found in any row, board is invalid
-        if (i == rows) {
-            return INVALID_BOARD;
+    size_t slot = (size_t) ((state + 1) * HASH_MULTIPLIER >> (64 - DEAD_END_BITS));
+    while (deadEnds->local[slot] != 0) {
+        if (deadEnds->local[slot] == state + 1) {
+            return 1;
         }
+        slot = (slot + 1) % DEAD_END_SLOTS;
     }
 
-    // Recursively validate the remaining disks
-    return validatePlayMoves(board, rows, columns, lastPlayed, numOfOccur - 1, players);
+    return 0;
 }
 
-
 /**
- * @brief Helper function to validate the number of plays per player
+ * @brief Remember a dead end of a replay
  * 
- * This function checks for illegal moves on the board by ensuring:
- * 1. No player has played out of turn.
- * 2. No player has played more than one extra turn compared to others.
+ * The table on the stack is kept at most half full. The dead end that
+ * would fill it further moves them all to the bitmap, whose size depends
+ * only on the column heights.
  * 
- * @param board The 2D board array
- * @param rows Number of rows in the board
- * @param columns Number of columns in the board
- * @param players Total number of players
- * @return The last player who played if the board is valid, 0 if the board is illegal
+ * @param deadEnds The dead ends
+ * @param state The state that leads nowhere, not stored yet
+ * @return 1 on success, 0 if the bitmap could not be allocated
  */
-int validatePlayTimes(char board[ROWS][COLS], int rows, int columns, int players) {
-    
-    const int MAX_DIFF_ALLOWED = 2;  // Maximum allowed difference in plays between players
-    int max = 0;                     // Tracks the maximum moves by a single player
-    int lastPlayedPlayer = 0;        // Tracks the last player who played
+int addDeadEnd(DeadEnds *deadEnds, uint64_t state) {
 
-    // Check every player against the next
-    for (int i = 0; i < players - 1; i++) {
-        char player = 'A' + i; // Current player as character
+    const uint64_t HASH_MULTIPLIER = 0x9E3779B97F4A7C15ULL;
 
-        // Get the number of moves for current and next player
-        int currCount = getNumOfOccurrences(board, rows, columns, player);
-        int nextCount = getNumOfOccurrences(board, rows, columns, player + 1);
-
-        // If next player played more than current, board is illegal
-        if (currCount < nextCount) {
-            return INVALID_BOARD;
+    if (deadEnds->bits == NULL && (deadEnds->used + 1) * 2 > DEAD_END_SLOTS) {
+        deadEnds->bits = (uint64_t *) calloc(deadEnds->states / 64 + 1, sizeof(uint64_t));
+        if (deadEnds->bits == NULL) {
+            return 0;
         }
-
-        // Update the last player who made a move
-        if (currCount >= nextCount) {
-            lastPlayedPlayer = i + 2; // +2 because player index starts at 0 and we compare with next
+        for (int i = 0; i < DEAD_END_SLOTS; i++) {
+            if (deadEnds->local[i] != 0) {
+                uint64_t old = deadEnds->local[i] - 1;
+                deadEnds->bits[old / 64] |= 1ULL << (old % 64);
+            }
         }
+    }
 
-        // Update maximum moves seen so far
-        if (currCount > max) {
-            max = currCount;
-        }
+    if (deadEnds->bits != NULL) {
+        deadEnds->bits[state / 64] |= 1ULL << (state % 64);
+        return 1;
+    }
 
-        // If any player played too many extra moves, board is illegal
-        if (max - currCount >= MAX_DIFF_ALLOWED || max - nextCount >= MAX_DIFF_ALLOWED) {
-            return INVALID_BOARD;
-        }
+    size_t slot = (size_t) ((state + 1) * HASH_MULTIPLIER >> (64 - DEAD_END_BITS));
+    while (deadEnds->local[slot] != 0) {
+        slot = (slot + 1) % DEAD_END_SLOTS;
     }
-    
-    // Return the last player who played if board is valid
-    return lastPlayedPlayer;
+    deadEnds->local[slot] = state + 1;
+    deadEnds->used++;
+
+    return 1;
 }
 
 
@@ -353,7 +427,7 @@ int validatePlayTimes(char board[ROWS][COLS], int rows, int columns, int players
  * @param player Player character to count, or EMPTY_POS to count all disks
  * @return Count of occurrences
  */
-int getNumOfOccurrences(char board[ROWS][COLS], int rows, int columns, char player) {
+int getNumOfOccurrences(char board[MAX_ROWS][MAX_COLS], int rows, int columns, char player) {
     
     int count = 0; // Initialize counter
     
@@ -381,8 +455,10 @@ int getNumOfOccurrences(char board[ROWS][COLS], int rows, int columns, char play
 /**
  * @brief Determine the winner on the board
  * 
- * This function iterates over all players and calls `checkForConnect`
- * to see if any player has achieved the required number of connected disks.
+ * This function packs the board into one bitboard per player in a single
+ * pass and then checks each player's bitboard for the required number of
+ * connected disks, so the cost grows by one line search per player. Only
+ * the first MAX_PLAYERS players can be told apart.
  * 
  * @param board The 2D board array
  * @param rows Number of rows in the board
@@ -391,17 +467,19 @@ int getNumOfOccurrences(char board[ROWS][COLS], int rows, int columns, char play
  * @param connect Number of consecutive disks needed for a win
  * @return The winner as a character if found, otherwise -1
  */
-char getWinner(char board[ROWS][COLS], int rows, int columns, int players, int connect) {
+char getWinner(char board[MAX_ROWS][MAX_COLS], int rows, int columns, int players, int connect) {
     
     const int NO_WINNER = -1;
-    int validate = 0; // Assume board is valid, no need for additional validation
+    BitPosition pos;
+
+    // Pack the board into one bitboard per player
+    loadBitPosition(board, rows, columns, players, &pos);
     
-    // Check each player for a winning sequence
-    for (int pl = 1; pl < players; pl++) {
-        int winner = checkForConnect(board, connect, rows, columns, validate, pl);
+    // Check each player for a winning sequence, the last one included
+    for (int pl = 1; pl <= players && pl <= MAX_PLAYERS; pl++) {
         
         // If a winner is found, return the player's character
-        if (winner) {
+        if (hasConnect(pos.disks[pl - 1], connect)) {
             return getPlayerAsChar(pl);
         }
     }
@@ -442,7 +520,7 @@ int isValidPlayer(int players, int player) {
  * @param connect Number of consecutive disks needed for a win
  * @return 1 if there is a winner, 0 if the board is full (tie), -1 if the game is ongoing
  */
-int getStatus(char board[ROWS][COLS], int rows, int columns, int players, int connect) {
+int getStatus(char board[MAX_ROWS][MAX_COLS], int rows, int columns, int players, int connect) {
     
     const int GAME_WINNED = 1;
     const int WINNER_NOT_FOUND = -1;
@@ -477,7 +555,7 @@ int getStatus(char board[ROWS][COLS], int rows, int columns, int players, int co
  * @param columns Number of columns in the board
  * @return 1 if the board is full, 0 if there is at least one empty cell
  */
-int checkForFullBoard(char board[ROWS][COLS], int columns) {
+int checkForFullBoard(char board[MAX_ROWS][MAX_COLS], int columns) {
     
     const int HAS_SPACE = 0;
     const int NO_SPACE = 1;
@@ -498,9 +576,10 @@ int checkForFullBoard(char board[ROWS][COLS], int columns) {
 /**
  * @brief Check if a player has won by connecting the required number of disks
  * 
- * This function iterates over the board, calling `getNumOfConnects` for each
- * disk of the given player. It tracks valid and invalid wins depending on the
- * `validate` flag. Returns the winner, no winner, or an invalid win indicator.
+ * The player's disks are packed into a bitboard and searched with
+ * shift-and-mask. With validation the win must also be one a single last
+ * move could have made: some disk on top of a column has to lie on every
+ * line of the player.
  * 
  * @param board The 2D board array
  * @param connect Number of consecutive disks needed for a win
@@ -510,270 +589,40 @@ int checkForFullBoard(char board[ROWS][COLS], int columns) {
  * @param player Player number to check
  * @return 1 for a valid win, 0 if no winner, -1 if invalid win detected
  */
-int checkForConnect(char board[ROWS][COLS], int connect, int rows, int columns, int validate, int player) {
+int checkForConnect(const char board[MAX_ROWS][MAX_COLS], int connect, int rows, int columns, int validate, int player) {
 
-    const int INVALID_WIN = 1;
+    PROBE(PROBE_CHECK_FOR_CONNECT);
     const int INVALID_WIN_RETURN = -1;
     const int VALID_WIN = 1;
-    const int ALLOWED_WINS = 1;
     const int NO_WINS = 0;
-    
-    int directions = 8;           // Number of directions to check (8: vertical, horizontal, diagonal)
-    int arr[8] = {0};             // Array to store consecutive disks in each direction
-    int wins = 0;                  // Count of valid wins found
+
     char playerAsChar = getPlayerAsChar(player); // Convert player number to character
-    
-    // Iterate over every cell in the board
+    Bitboard disks = 0;
+    Bitboard tops = 0;
+
+    // Pack the player's disks and note which of them have nothing above
     for (int row = 0; row < rows; row++) {
         for (int col = 0; col < columns; col++) {
-            
-            // Only check cells that belong to the player
             if (board[row][col] == playerAsChar) {
+                disks |= getCellBit(row, col);
 
-                // Check for connects starting from this position
-                int isWin = getNumOfConnects(board, connect - 1, rows, columns, arr, col, row,
-                                             playerAsChar, directions, connect, validate);
-
-                if (validate) {
-                    // If validating for invalid wins
-                    if (isWin == INVALID_WIN) {
-                        return INVALID_WIN_RETURN; // Found invalid win
-                    } else if (isWin > INVALID_WIN) {
-                        wins++;
-                        if (wins > ALLOWED_WINS) {
-                            return INVALID_WIN_RETURN; // More than one win not allowed
-                        }
-                    }
-                } else if (isWin > INVALID_WIN) {
-                    // If not validating, any valid win is sufficient
-                    return VALID_WIN;
-                }
-
-                // Reset the directions array before next iteration
-                for (int i = 0; i < directions; i++) {
-                    arr[i] = 0;
+                if (row == 0 || board[row - 1][col] == EMPTY_POS) {
+                    tops |= getCellBit(row, col);
                 }
             }
         }
     }
-    
-    // Return result based on the number of wins found
-    if (wins) {
-        return VALID_WIN;
-    }
-
-    return NO_WINS; // No winner found
-}
-
-
-/**
- * @brief Check if a disk at a given position is a valid "win disk"
- * 
- * A disk is considered a possible win disk if it is either:
- *   1. In the first row, or
- *   2. The first disk in its column (i.e., nothing above it)
- * 
- * If valid, the position is temporarily marked with a special character
- * to prevent counting it as part of multiple win sequences.
- * 
- * @param board The 2D board array
- * @param row Row index of the disk
- * @param col Column index of the disk
- * @return 1 if the disk is a valid win disk, 0 otherwise
- */
-int isValidWin(char board[ROWS][COLS], int row, int col) {
-    
-    const int VALID_WIN_DISK = 1;
-    const char POSSIBLE_WIN = '+'; // Temporary marker for possible win
-    const int FIRST_ROW = 0;
-    
-    // Check if the disk is in the first row or has nothing above it
-    if (row == FIRST_ROW || board[row - 1][col] == EMPTY_POS) {
-        
-        // Temporarily mark the position to prevent double counting
-        board[row][col] = POSSIBLE_WIN;
-        
-        // This is a valid win disk
-        return VALID_WIN_DISK;
-    }
-    
-    // Not a valid win disk
-    return !VALID_WIN_DISK;
-}
-
-/**
- * @brief Check if a given position on the board contains a specific player
- *        and increment a counter array at a specified index if true.
- * 
- * This function ensures the position is within board boundaries, checks
- * for the presence of the player at that position, and increments the
- * counter array if both conditions are met.
- * 
- * @param board The 2D board array
- * @param row Row index to check
- * @param col Column index to check
- * @param player The player character to check for
- * @param countArr Array storing counts for different positions or directions
- * @param pos Index in countArr to increment if player is present
- * @param rows Total number of rows in the board
- * @param columns Total number of columns in the board
- * @return 1 if the operation was successful (player found and counter incremented), 0 otherwise
- */
-int storeCount(char board[ROWS][COLS], int row, int col, char player, int countArr[], int pos,
-               int rows, int columns) {
-    
-    const int OP_SUCCESS = 1;
-
-    // Check if the position is within board boundaries
-    if (row >= 0 && row < rows && col >= 0 && col < columns) {
-        // Check if the specified player is at this position
-        if (board[row][col] == player) {
-            // Increment the counter at the given index
-            countArr[pos]++;
-            return OP_SUCCESS; // Operation successful
-        }
-    }
-
-    // Position invalid or player not found
-    return !OP_SUCCESS;
-}
-
-/**
- * @brief Validate if a player's move creates a valid win on the board
- * 
- * This function checks in all directions (vertical, horizontal, diagonal)
- * using the results from `getNumOfConnects` (stored in arr[]) to see if 
- * any sequence qualifies as a win. A sequence is considered valid if at 
- * least one disk in it has no disk above it (checked using isValidWin).
- * 
- * @param board The 2D board array
- * @param arr Array of counts in 8 directions (bottom, top, right, left, 
- *            bottom-right, bottom-left, top-right, top-left)
- * @param originalConnect The required number of connected disks for a win
- * @param connect Current offset to check along each direction
- * @param row Row index of the last move
- * @param col Column index of the last move
- * @return 1 if a valid win disk is found, 0 otherwise
- */
-int validateWin(char board[ROWS][COLS], int arr[], int originalConnect, int connect, int row, int col) {
-    
-    const int VALID_WIN = 1;
-    int res = 0;
-
-    // Check downward
-    if (arr[0] == originalConnect) {
-        res += isValidWin(board, row + connect, col);
-    }
-    // Check upward
-    if (arr[1] == originalConnect) {
-        res += isValidWin(board, row - connect, col);
-    }
-    // Check right
-    if (arr[2] == originalConnect) {
-        res += isValidWin(board, row, col + connect);
-    }
-    // Check left
-    if (arr[3] == originalConnect) {
-        res += isValidWin(board, row, col - connect);
-    }
-    // Check bottom-right diagonal
-    if (arr[4] == originalConnect) {
-        res += isValidWin(board, row + connect, col + connect);
-    }
-    // Check bottom-left diagonal
-    if (arr[5] == originalConnect) {
-        res += isValidWin(board, row + connect, col - connect);
-    }
-    // Check top-right diagonal
-    if (arr[6] == originalConnect) {
-        res += isValidWin(board, row - connect, col + connect);
-    }
-    // Check top-left diagonal
-    if (arr[7] == originalConnect) {
-        res += isValidWin(board, row - connect, col - connect);
-    }
-    
-    // Return 1 if any valid win disk was found
-    if (res > 0) {
-        return VALID_WIN;
-    }
-    
-    // No valid win found
-    return !VALID_WIN;
-}
-
-/**
- * @brief Recursively checks a position for connected disks in all directions
- * 
- * This function inspects all eight directions around a given position and counts
- * consecutive disks for the same player. It can also validate the sequence to ensure
- * that at least one disk in the sequence is a "possible win disk" (i.e., has no disk
- * above it). The recursion decrements `connect` with each call to explore all positions
- * along the sequence.
- * 
- * @param board The 2D board array
- * @param connect Current offset along the direction to check
- * @param rows Number of rows in the board
- * @param columns Number of columns in the board
- * @param countArr Array storing the count of disks in each of the 8 directions
- * @param col Column index of the starting position
- * @param row Row index of the starting position
- * @param player Player character to check for
- * @param size Size of countArr (typically 8 for 8 directions)
- * @param originalConnect The required number of connected disks for a win
- * @param toValidate Flag indicating whether to validate the sequence as a possible win
- * @return Number > 1 if there was a valid win, 0 if no wins, 1 if an invalid win
- */
-int getNumOfConnects(char board[ROWS][COLS], int connect, int rows, int columns,
-                     int countArr[], int col, int row, char player, int size,
-                     int originalConnect, int toValidate) {
-
-    const int NO_WINS = 0;
-
-    // Exit condition: when connect reaches -1, check if any direction has a complete sequence
-    if (connect == -1) {
-        for (int i = 0; i < size; i++) {
-            if (countArr[i] == originalConnect) {
-                return originalConnect + 1; // Found a complete sequence
-            }
-        }
-        return NO_WINS; // No wins found
-    }
-
-    int exitFlag = 0;
-
-    // Check all eight directions for a matching disk at the current offset
-    exitFlag += storeCount(board, row + connect, col, player, countArr, 0, rows, columns); // Down
-    exitFlag += storeCount(board, row - connect, col, player, countArr, 1, rows, columns); // Up
-    exitFlag += storeCount(board, row, col + connect, player, countArr, 2, rows, columns); // Right
-    exitFlag += storeCount(board, row, col - connect, player, countArr, 3, rows, columns); // Left
-    exitFlag += storeCount(board, row + connect, col + connect, player, countArr, 4, rows, columns); // Bottom-Right
-    exitFlag += storeCount(board, row + connect, col - connect, player, countArr, 5, rows, columns); // Bottom-Left
-    exitFlag += storeCount(board, row - connect, col - connect, player, countArr, 6, rows, columns); // Top-Left
-    exitFlag += storeCount(board, row - connect, col + connect, player, countArr, 7, rows, columns); // Top-Right
 
-    // If no matching disks found in any direction, return NO_WINS
-    if (!exitFlag) {
+    if (!hasConnect(disks, connect)) {
         return NO_WINS;
     }
 
-    // Recursive call with connect - 1 to move closer to the end of the sequence
-    int result = getNumOfConnects(board, connect - 1, rows, columns, countArr, col,
-                                  row, player, size, originalConnect, toValidate);
-
-    // If validating and still within the original connect length
-    if (connect < originalConnect && result && toValidate) {
-        int validate = validateWin(board, countArr, originalConnect, connect, row, col);
-
-        // Decrement result if it's not a possible win disk
-        if (!validate) {
-            return result - 1;
-        } else {
-            return result; // Valid win disk, keep result
-        }
+    // A last move must have completed every line at once
+    if (validate && !(getCommonLineCells(disks, connect) & tops)) {
+        return INVALID_WIN_RETURN;
     }
 
-    return result; // Return result of recursion
+    return VALID_WIN;
 }
 
 /**
@@ -788,7 +637,7 @@ int getNumOfConnects(char board[ROWS][COLS], int connect, int rows, int columns,
  * @param column Column index to undo the move
  * @return 1 if the undo was successful, 0 otherwise
  */
-int undoMove(char board[ROWS][COLS], int rows, int columns, int column) {
+int undoMove(char board[MAX_ROWS][MAX_COLS], int rows, int columns, int column) {
     
     const int UNDO_SUCCESS = 1;
     const int MIN_COL = 0;
@@ -825,16 +674,15 @@ int undoMove(char board[ROWS][COLS], int rows, int columns, int column) {
  * @param players Total number of players
  * @param player Character representing the player
  * @param column Column index where the player wants to place the marker
- * @return 1 if the move was successful, 0 otherwise
+ * @return The row the marker landed in, MOVE_FAILED if the move is illegal
  */
-int makeMove(char board[ROWS][COLS], int rows, int columns, int players, char player, int column) {
+int makeMove(char board[MAX_ROWS][MAX_COLS], int rows, int columns, int players, char player, int column) {
     
-    const int MOVE_SUCCESS = 1;
     const int MIN_ROW_COL = 0;
 
     // Validate the column index
     if (column < MIN_ROW_COL || column >= columns) {
-        return !MOVE_SUCCESS; // Invalid column
+        return MOVE_FAILED; // Invalid column
     }
     
     // Convert player character to integer representation
@@ -842,7 +690,7 @@ int makeMove(char board[ROWS][COLS], int rows, int columns, int players, char pl
     
     // Validate the player number
     if (!isValidPlayer(players, integerPlayer)) {
-        return !MOVE_SUCCESS; // Invalid player
+        return MOVE_FAILED; // Invalid player
     }
 
     // Find the lowest empty row in the selected column
@@ -850,13 +698,128 @@ int makeMove(char board[ROWS][COLS], int rows, int columns, int players, char pl
     
     // Check if the column is full
     if (emptyRow < MIN_ROW_COL) {
-        return !MOVE_SUCCESS; // Column full
+        return MOVE_FAILED; // Column full
     }
     
     // Place the player's marker in the board
     board[emptyRow][column] = player;
     
-    return MOVE_SUCCESS; // Move successful
+    return emptyRow; // Move successful
+}
+
+/**
+ * @brief Count a player's disks in a line starting next to a position
+ * 
+ * Walks away from the given position one step at a time in the direction
+ * (rowStep, colStep) and stops at the first cell that is off the board or
+ * does not hold the player's disk.
+ * 
+ * @param board The 2D board array
+ * @param rows Number of rows in the board
+ * @param columns Number of columns in the board
+ * @param row Row index of the starting position
+ * @param column Column index of the starting position
+ * @param rowStep Row offset of one step
+ * @param colStep Column offset of one step
+ * @param limit Maximum number of disks to count
+ * @return Number of consecutive disks found
+ */
+int countInDirection(char board[MAX_ROWS][MAX_COLS], int rows, int columns, int row, int column,
+                     int rowStep, int colStep, int limit) {
+    
+    char player = board[row][column];
+    int count = 0;
+
+    // Step away from the position while the line continues
+    for (int i = 1; i <= limit; i++) {
+        int r = row + i * rowStep;
+        int c = column + i * colStep;
+
+        if (r < 0 || r >= rows || c < 0 || c >= columns || board[r][c] != player) {
+            break;
+        }
+        count++;
+    }
+    
+    return count;
+}
+
+/**
+ * @brief Check if the disk at a given position completes a line
+ * 
+ * Only the four lines through the position (vertical, horizontal and the
+ * two diagonals) are inspected, so the cost is O(connect) instead of a
+ * scan of the whole board. Meant to be called right after a move.
+ * 
+ * @param board The 2D board array
+ * @param rows Number of rows in the board
+ * @param columns Number of columns in the board
+ * @param connect Number of consecutive disks needed for a win
+ * @param row Row index of the last placed disk
+ * @param column Column index of the last placed disk
+ * @return 1 if the disk is part of a winning line, 0 otherwise
+ */
+int checkLastMove(char board[MAX_ROWS][MAX_COLS], int rows, int columns, int connect, int row, int column) {
+    
+    // Row and column steps of the four lines (the opposite step is the negation)
+    const int rowSteps[4] = {1, 0, 1, 1};
+    const int colSteps[4] = {0, 1, 1, -1};
+
+    for (int dir = 0; dir < 4; dir++) {
+        // The placed disk plus its neighbours on both sides of the line
+        int count = 1;
+        count += countInDirection(board, rows, columns, row, column,
+                                  rowSteps[dir], colSteps[dir], connect - 1);
+        count += countInDirection(board, rows, columns, row, column,
+                                  -rowSteps[dir], -colSteps[dir], connect - 1);
+
+        if (count >= connect) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Make a move and report the game outcome it produced
+ * 
+ * This function places the player's disk with `makeMove` and then checks
+ * only the lines through the new disk, from the row `makeMove` reports,
+ * with `checkLastMove`. A tie is detected from the number of moves played
+ * instead of scanning the board.
+ * 
+ * @param board The 2D board array
+ * @param rows Number of rows in the board
+ * @param columns Number of columns in the board
+ * @param players Total number of players
+ * @param connect Number of consecutive disks needed for a win
+ * @param player Character representing the player
+ * @param column Column index where the player wants to place the disk
+ * @param movesPlayed Number of disks on the board, updated on success
+ * @return GAME_WON, GAME_TIE or GAME_ON after the move, MOVE_FAILED if the move is illegal
+ */
+int playMove(char board[MAX_ROWS][MAX_COLS], int rows, int columns, int players, int connect, char player, int column,
+             int *movesPlayed) {
+    
+    // Place the disk, rejecting illegal columns and players
+    int row = makeMove(board, rows, columns, players, player, column);
+    if (row == MOVE_FAILED) {
+        return MOVE_FAILED;
+    }
+    (*movesPlayed)++;
+    
+    // Only the lines through the new disk can have changed
+    if (checkLastMove(board, rows, columns, connect, row, column)) {
+        return GAME_WON;
+    }
+    
+    // Every cell is taken once all moves were played
+    if (*movesPlayed == rows * columns) {
+        return GAME_TIE;
+    }
+    
+    return GAME_ON;
 }
 
 /**
@@ -870,8 +833,9 @@ int makeMove(char board[ROWS][COLS], int rows, int columns, int players, char pl
  * @param column The column index to check
  * @return Row index of the bottom-most empty cell, or -1 if the column is full
  */
-int getBottomEmptyPos(char board[ROWS][COLS], int rows, int column) {
+int getBottomEmptyPos(char board[MAX_ROWS][MAX_COLS], int rows, int column) {
     
+    PROBE(PROBE_BOTTOM_EMPTY_POS);
     const int POS_NOT_FOUND = -1;
 
     // Iterate from the bottom row to the top row
@@ -896,113 +860,31 @@ int getBottomEmptyPos(char board[ROWS][COLS], int rows, int column) {
  *   52-61  -> '0'-'9'
  *   62     -> '+'
  *   63     -> '/'
+ * The characters are looked up in the `base64Digits` table.
  * 
  * @param input Integer to convert (expected 0-63)
- * @return Corresponding Base64 character, or -1 if input is invalid
+ * @return Corresponding Base64 character, '/' if input is out of range
  */
 char getIntegerAs64Base(int input) {
-    
-    const int NOT_SUCCESS = -1;        // Return value for invalid input
-    const int A_64_BASE = 0;           // Start of uppercase letters
-    const int LETTERS_COUNT = 26;      // Number of letters in alphabet
-    const int SMALL_A_64_BASE = 26;    // Start of lowercase letters
-    const int ZERO_64_BASE = 52;       // Start of digits
-    const int NUMBER_COUNT = 10;        // Number of digits (0-9)
-    const int PLUS_64BASE = 62;        // Base64 value for '+'
 
-    // Map input to uppercase letter
-    if (input >= A_64_BASE && input <= A_64_BASE + LETTERS_COUNT - 1) {
-        return 'A' + (input - A_64_BASE);
-    }
+    const int DIGITS = 64; // Base64 digits in the table
 
-    // Map input to lowercase letter
-    if (input >= SMALL_A_64_BASE && input <= SMALL_A_64_BASE + LETTERS_COUNT - 1) {
-        return 'a' + (input - SMALL_A_64_BASE);
-    }
-
-    // Map input to digit
-    if (input >= ZERO_64_BASE && input <= ZERO_64_BASE + NUMBER_COUNT - 1) {
-        return '0' + (input - ZERO_64_BASE);
-    }
-
-    // Map input to special Base64 characters
-    if (input == PLUS_64BASE) {
-        return '+';
-    } else {
-        return '/';
-    }
-
-    // Return error if input was not valid (this line is technically unreachable)
-    return NOT_SUCCESS;
+    // 63 is '/' in the table, and like the original mapping anything out of range is '/' too
+    return input >= 0 && input < DIGITS ? base64Digits[input] : '/';
 }
 
 /**
  * @brief Convert a Base64 character to its corresponding integer value
  * 
  * This function maps Base64 characters (A-Z, a-z, 0-9, +, /) to
- * integer values from 0 to 63.
+ * integer values from 0 to 63 with the `base64Values` table. Any other
+ * character is read as 63, like '/'.
  * 
  * @param input The Base64 character to convert
  * @return The integer representation of the Base64 character
  */
 int get64BaseAsInteger(char input) {
-    
-    // Initialize constants
-    const char PLUS = '+';          // '+' corresponds to 62
-    const int SMALL_A_BASE_DIFF = 26; // Offset for lowercase letters
-    const int ZERO_BASE_DIFF = 52;    // Offset for digits
-    const int PLUS_64_BASE = 62;      // Base64 value for '+'
-    const int SLASH_64_BASE = 63;     // Base64 value for '/'
-
-    // Check if the character is an uppercase letter (A-Z)
-    if (input >= 'A' && input <= 'Z') {
-        return input - 'A'; // Map 'A'-'Z' to 0-25
-
-    // Check if the character is a lowercase letter (a-z)
-    } else if (input >= 'a' && input <= 'z') {
-        return input - ('a' - SMALL_A_BASE_DIFF); // Map 'a'-'z' to 26-51
-
-    // Check if the character is a digit (0-9)
-    } else if (input >= '0' && input <= '9') {
-        return input - ('0' - ZERO_BASE_DIFF); // Map '0'-'9' to 52-61
-
-    // Check if the character is '+'
-    } else if (input == PLUS) {
-        return PLUS_64_BASE;
-
-    // Otherwise, treat it as '/'
-    } 
-    return SLASH_64_BASE;
-}
-
-/**
- * @brief Insert a Base64 character and its occurrence into a string
- * 
- * This function uses pointer arithmetic to append two characters:
- *   1. The number of occurrences converted to a Base64 character
- *   2. The character itself
- * 
- * @param code Pointer to the current end of the string
- * @param numOfOccurrences Number of occurrences of a given character
- * @param theChar The character to insert
- * @return Pointer to the position after the newly inserted characters
- */
-char * insertBase64CharIntoString(char *code, char numOfOccurrences, char theChar) {
-    
-    // Convert occurrence count to Base64 and store at current position
-    *code = getIntegerAs64Base(numOfOccurrences);
-    
-    // Move pointer to next position
-    code++;
-    
-    // Store the actual character at the new position
-    *code = theChar;
-    
-    // Move pointer past the newly stored character
-    code++;
-    
-    // Return the pointer to the updated end of the string
-    return code;
+    return base64Values[(unsigned char) input];
 }
 
 /**
@@ -1010,46 +892,14 @@ char * insertBase64CharIntoString(char *code, char numOfOccurrences, char theCha
  * 
  * This function reads a string encoded with Base64 counts and characters,
  * and populates the board accordingly. It stops decoding when it reaches
- * the end of the string.
+ * the end of the string or after the last row of the board, and clips runs
+ * to the width of the board. The work is done by `decodeBoard` (codec.c).
  * 
  * @param code Pointer to the encoded board string
  * @param board 2D array representing the game board
  */
-void decode(const char *code, char board[ROWS][COLS]) {
-    const char END_OF_LINE = '/'; // Marker for end of a row
-    int row = 0;
-    int col = 0;
-
-    // Process each character until the end of the string
-    while (*code != '\0') {
-        
-        // Get the number of times to insert the next character
-        int cols = get64BaseAsInteger(*code);
-        
-        // Move pointer to the character to insert
-        code++;
-        char currChar = *code;
-
-        // Move pointer past the character
-        code++;
-
-        // Fill the board with the current character 'cols' times
-        for (int i = col; cols > 0; cols--) {
-            // Store current column to update 'col' after loop
-            col = i;
-            board[row][i++] = currChar;
-        }
-
-        // Move to the next column
-        col++;
-
-        // Check if we've reached the end of the row
-        if (*code == END_OF_LINE) {
-            row++;   // Move to the next row
-            col = 0; // Reset column to 0
-            code++;  // Move past the end-of-line marker
-        }
-    }
+void decode(const char *code, char board[MAX_ROWS][MAX_COLS]) {
+    decodeBoard(code, board);
 }
 
 /**
@@ -1058,106 +908,135 @@ void decode(const char *code, char board[ROWS][COLS]) {
  * This function converts sequences of the same character into a Base64
  * count followed by the character itself, row by row. Each row ends with
  * a special end-of-row marker ('/'), and the string ends with '\0'.
+ * The work is done by the table-driven `encodeBoard` (codec.c).
  * 
  * @param board The 2D board array to encode
  * @param rows Number of rows in the board
  * @param columns Number of columns in the board
  * @param code Pointer to the string buffer to store the encoded board
  */
-void encode(const char board[ROWS][COLS], int rows, int columns, char *code) {
-    
-    const char END_OF_ROW = '/';     // Marker for end of a row
-    const char END_OF_STRING = '\0'; // Null terminator for the string
-    const int RIGHT_BOUNDARY = columns - 2; // Prevent out-of-bounds access
-    int counter = 1; // Count consecutive occurrences of a character
+void encode(const char board[MAX_ROWS][MAX_COLS], int rows, int columns, char *code) {
+    encodeBoard(board, rows, columns, code);
+}
 
-    // Iterate through every row of the board
-    for (int row = 0; row < rows; row++) {
-        // Iterate through every column of the current row
-        for (int col = 0; col < columns; col++) {
-            
-            // Ensure we do not access out-of-bounds for next column
-            if (col < RIGHT_BOUNDARY) {
-                // Check if current character is the same as the next
-                if (board[row][col] == board[row][col + 1]) {
-                    counter++; // Increment counter for consecutive characters
-                } else {
-                    // Insert the sequence into the encoded string
-                    code = insertBase64CharIntoString(code, counter, board[row][col]);
-                    counter = 1; // Reset counter
-                }
-            } else {
-                // Handle the last columns to avoid array overflow
-                if (board[row][col] == board[row][col + 1]) {
-                    counter++;
-                    code = insertBase64CharIntoString(code, counter, board[row][col]);
-                } else {
-                    // Store current and next character separately
-                    code = insertBase64CharIntoString(code, counter, board[row][col]);
-                    code = insertBase64CharIntoString(code, 1, board[row][col + 1]);
-                }
-                counter = 1; // Reset counter
-                break; // End of row processing
-            }
-        }
+/**
+ * @brief Choose the move of the engine player with an anytime search and print it
+ * 
+ * @param board The board, the engine is to move
+ * @param engine The solver of the engine
+ * @param milliseconds Thinking time per move
+ * @return The column to play, NO_MOVE if the board cannot be searched
+ */
+int chooseRunMove(char board[MAX_ROWS][MAX_COLS], Solver *engine, int milliseconds) {
 
-        // Append end-of-row marker
-        *code = END_OF_ROW;
-        code++;
+    Game game;
+    SearchResult result;
+
+    if (!loadGame(&game, board, geometry.rows, geometry.columns) ||
+        !searchDeadline(engine, &game, milliseconds / 1000.0, &result)) {
+        return NO_MOVE;
     }
 
-    // Terminate the string
-    *code = END_OF_STRING;
+    printf("Engine plays column %d (depth %d, score %+.2f, %.0f ms)\n", result.bestMove, result.depth,
+           (double) result.score / SEARCH_SCALE, result.seconds * 1000);
+    return result.bestMove;
 }
 
+/**
+ * @brief Read the column of a human player while the engine ponders
+ * 
+ * The engine, if any, searches the board on a background thread while the
+ * player thinks, so its own search after the reply starts from that work.
+ * The background search is cancelled as soon as the input arrives.
+ * 
+ * @param board The board, the human player is to move
+ * @param engine Solver of the engine player, or NULL
+ * @param col Set to the column entered
+ * @return 1 if a number was read, 0 if the input ended or is not a number
+ */
+int readColumn(char board[MAX_ROWS][MAX_COLS], Solver *engine, int *col) {
+
+    Ponder ponder;
+    Game game;
+    int pondering = engine != NULL && loadGame(&game, board, geometry.rows, geometry.columns) &&
+                    startPonder(&ponder, engine, &game);
+
+    // Prompt current player to select a column
+    printf("Enter a column: ");
+    fflush(stdout);
+    int read = scanf("%d", col) == 1;
+
+    if (pondering) {
+        stopPonder(&ponder);
+        if (ponder.result.depth > 0) {
+            printf("Engine pondered to depth %d, expecting column %d\n", ponder.result.depth, ponder.result.bestMove);
+        }
+    }
+
+    return read;
+}
 
 /**
  * @brief Main game loop that handles turns, player input, and determines game status
  * 
  * This function initializes the board, repeatedly prompts players to make moves,
  * updates and prints the board, and checks for a winner or tie after each turn.
+ * The engine player, if any, moves on its own within its time budget and
+ * keeps searching while the other player thinks.
+ * 
+ * @param gameFile Game file to append the game to when it ends, or NULL
+ * @param players Players taking turns, 2 to MAX_PLAYERS; 2 with an engine or a game file
+ * @param engine Solver of the engine player, or NULL for human players only
+ * @param enginePlayer The player the engine moves for ('A' or 'B')
+ * @param milliseconds Thinking time of the engine per move
  */
-void run() {
+void run(FILE *gameFile, int players, Solver *engine, char enginePlayer, int milliseconds) {
 
     // Initialize the board
-    char board[ROWS][COLS];
-    initBoard(board, ROWS, COLS);
-    printBoard(board, ROWS, COLS);
+    char board[MAX_ROWS][MAX_COLS];
+    initBoard(board, geometry.rows, geometry.columns);
+    printBoard(board, geometry.rows, geometry.columns);
 
     // Game state variables
     char winner = -1;       // Stores winner character, -1 if no winner yet
-    char status = -1;       // Game status: 1 = winner, 0 = tie, -1 = ongoing
-    int turn = 1;           // 1 for player A's turn, 0 for player B
+    int status = GAME_ON;   // Game status: 1 = winner, 0 = tie, -1 = ongoing
+    int moves = 0;          // Number of disks on the board
     int col;                // Column input by the player
     char pl = 'A';          // Current player character
+    int8_t columns[MAX_MOVES]; // Column of every move, for the game file
 
     // Main loop: runs until a winner or a full board
-    while (winner == -1 && status == -1) {
-        // Prompt current player to select a column
-        printf("Enter a column: ");
-        scanf("%d", &col);
-
-        // Determine which player's turn it is
-        pl = turn ? 'A' : 'B';
+    while (status == GAME_ON) {
+        // Determine which player's turn it is, 'A' first
+        pl = (char) ('A' + moves % players);
+
+        if (engine != NULL && pl == enginePlayer) {
+            col = chooseRunMove(board, engine, milliseconds);
+        } else if (!readColumn(board, engine, &col)) {
+            break; // Input ended or is not a number
+        }
 
-        // Attempt to make the move
-        if (!makeMove(board, ROWS, COLS, NUM_PLAYERS, pl, col)) {
+        // Attempt the move, its result already tells the game status
+        status = playMove(board, geometry.rows, geometry.columns, players, geometry.connect, pl, col, &moves);
+        if (status == MOVE_FAILED) {
             printf("Invalid column\n");  // Invalid input, retry
+            status = GAME_ON;
             continue;
-        } else {
-            turn = !turn;               // Switch turn
-            printBoard(board, ROWS, COLS); // Display updated board
         }
 
-        // Check for a winner and overall game status
-        winner = getWinner(board, ROWS, COLS, NUM_PLAYERS, CONNECT);
-        status = getStatus(board, ROWS, COLS, NUM_PLAYERS, CONNECT);
+        columns[moves - 1] = (int8_t) col;
+        printBoard(board, geometry.rows, geometry.columns); // Display updated board
+
+        // Only the player who just moved can have won
+        if (status == GAME_WON) {
+            winner = pl;
+        }
     }
 
     // Game finished: print outcome
-    if (status == 1) {
+    if (status == GAME_WON) {
         printf("Game over\n");
-    } else if (status == 0) {
+    } else if (status == GAME_TIE) {
         printf("Tie\n");
     } 
 
@@ -1165,15 +1044,888 @@ void run() {
     if (winner != -1) {
         printf("The winner is %c\n", winner);
     }
+
+    // Keep the game, even an unfinished one
+    if (gameFile != NULL && moves > 0 && !appendGame(gameFile, columns, moves)) {
+        printf("Cannot save the game\n");
+    }
+}
+
+/**
+ * @brief Solve an encoded board and print the result
+ * 
+ * Prints the game-theoretic score for the player to move, the column that
+ * achieves it and the node throughput of the search.
+ * 
+ * @param code The board in the `encode()` format
+ * @param threads Number of search threads
+ * @param bookPath Path of an opening book to use, or NULL
+ * @return 0 on success, 1 if the board or book is invalid or memory ran out
+ */
+int runSolve(const char *code, int threads, const char *bookPath) {
+
+    Solver *solver = makeSolver();
+    OpeningBook *book = NULL;
+    Tablebase *tablebase = NULL;
+    SolveResult result;
+
+    // Check for failed allocation
+    if (solver == NULL) {
+        printf("Out of memory\n");
+        return 1;
+    }
+    setSolverThreads(solver, threads);
+
+    // The file is either an opening book or a tablebase
+    if (bookPath != NULL) {
+        book = openBook(bookPath);
+        tablebase = book == NULL ? openTablebase(bookPath) : NULL;
+        if (book == NULL && tablebase == NULL) {
+            printf("Invalid book\n");
+            freeSolver(solver);
+            return 1;
+        }
+        setSolverBook(solver, book);
+        setSolverTablebase(solver, tablebase);
+    }
+
+    if (!solveCode(solver, code, &result)) {
+        printf("Invalid board\n");
+        closeBook(book);
+        closeTablebase(tablebase);
+        freeSolver(solver);
+        return 1;
+    }
+
+    printf("Score: %d\n", result.score);
+    printf("Best column: %d\n", result.bestMove);
+    printf("Threads: %d\n", solver->threads);
+    printf("Nodes: %llu\n", result.nodes);
+    printf("Time: %.3f s\n", result.seconds);
+    printf("Nodes/sec: %.0f\n", result.seconds > 0 ? result.nodes / result.seconds : 0.0);
+
+    closeBook(book);
+    closeTablebase(tablebase);
+    freeSolver(solver);
+    return 0;
+}
+
+/**
+ * @brief Search an encoded board within a time budget and print every iteration
+ * 
+ * Prints the depth, score, best column, nodes and time of every completed
+ * iteration, then the chosen column and how long the search took against
+ * its budget.
+ * 
+ * @param code The board in the `encode()` format
+ * @param milliseconds Time budget of the search
+ * @param threads Number of search threads
+ * @return 0 on success, 1 if the board or budget is invalid or memory ran out
+ */
+int runSearch(const char *code, int milliseconds, int threads) {
+
+    char board[MAX_ROWS][MAX_COLS];
+    Game game;
+    SearchResult result;
+
+    if (milliseconds <= 0) {
+        printf("Invalid budget\n");
+        return 1;
+    }
+
+    if (!isWellFormedCode(code, geometry.rows, geometry.columns)) {
+        printf("Invalid board\n");
+        return 1;
+    }
+    initBoard(board, geometry.rows, geometry.columns);
+    decode(code, board);
+    if (!loadGame(&game, board, geometry.rows, geometry.columns) ||
+        !isValidBoard(board, geometry.rows, geometry.columns, NUM_PLAYERS, geometry.connect)) {
+        printf("Invalid board\n");
+        return 1;
+    }
+
+    Solver *solver = makeSolver();
+    if (solver == NULL) {
+        printf("Out of memory\n");
+        return 1;
+    }
+    setSolverThreads(solver, threads);
+
+    if (!searchDeadline(solver, &game, milliseconds / 1000.0, &result)) {
+        printf("Invalid board\n");
+        freeSolver(solver);
+        return 1;
+    }
+
+    for (int i = 0; i < result.iterationCount; i++) {
+        const SearchIteration *iteration = &result.iterations[i];
+        printf("Depth %2d  score %+7.2f  column %d  nodes %12llu  time %8.3f ms\n", iteration->depth,
+               (double) iteration->score / SEARCH_SCALE, iteration->bestMove, iteration->nodes,
+               iteration->seconds * 1000);
+    }
+    printf("Best column: %d%s\n", result.bestMove, result.exact ? " (proven)" : "");
+    printf("Threads: %d\n", solver->threads);
+    printf("Nodes: %llu\n", result.nodes);
+    printf("Time: %.3f ms of %d ms\n", result.seconds * 1000, milliseconds);
+    printf("Nodes/sec: %.0f\n", result.seconds > 0 ? result.nodes / result.seconds : 0.0);
+
+    freeSolver(solver);
+    return 0;
+}
+
+/**
+ * @brief Play the interactive game against the anytime search
+ * 
+ * @param milliseconds Thinking time of the engine per move
+ * @param enginePlayer The player the engine moves for ('A' or 'B')
+ * @param threads Number of search threads
+ * @param path Game file to append the game to, or NULL
+ * @return 0 on success, 1 if an argument is invalid or memory ran out
+ */
+int runVersus(int milliseconds, char enginePlayer, int threads, const char *path) {
+
+    FILE *gameFile = NULL;
+
+    if (milliseconds <= 0 || (enginePlayer != 'A' && enginePlayer != 'B')) {
+        printf("Invalid engine\n");
+        return 1;
+    }
+
+    Solver *solver = makeSolver();
+    if (solver == NULL) {
+        printf("Out of memory\n");
+        return 1;
+    }
+    setSolverThreads(solver, threads);
+
+    if (path != NULL && (gameFile = openGameWriter(path)) == NULL) {
+        printf("Cannot open game file %s\n", path);
+        freeSolver(solver);
+        return 1;
+    }
+
+    run(gameFile, NUM_PLAYERS, solver, enginePlayer, milliseconds);
+
+    if (gameFile != NULL) {
+        fclose(gameFile);
+    }
+    freeSolver(solver);
+    return 0;
+}
+
+/**
+ * @brief Choose a move for an encoded board with Monte Carlo Tree Search and print it
+ * 
+ * @param code The board in the `encode()` format
+ * @param budget Number of playouts, or a time limit such as "500ms"
+ * @param threads Number of search threads
+ * @return 0 on success, 1 if the board is invalid or memory ran out
+ */
+int runMcts(const char *code, const char *budget, int threads) {
+
+    char board[MAX_ROWS][MAX_COLS];
+    char *unit;
+    Game game;
+    MctsConfig config;
+    MctsResult result;
+
+    initMctsConfig(&config);
+    config.threads = threads;
+
+    // A bare number counts playouts, a number with "ms" is a time limit
+    long amount = strtol(budget, &unit, 10);
+    if (amount <= 0 || (*unit != '\0' && strcmp(unit, "ms") != 0)) {
+        printf("Invalid budget %s\n", budget);
+        return 1;
+    }
+    if (*unit == '\0') {
+        config.playouts = amount;
+    } else {
+        config.milliseconds = (int) amount;
+    }
+
+    if (!isWellFormedCode(code, geometry.rows, geometry.columns)) {
+        printf("Invalid board\n");
+        return 1;
+    }
+    initBoard(board, geometry.rows, geometry.columns);
+    decode(code, board);
+    if (!loadGame(&game, board, geometry.rows, geometry.columns) ||
+        !isValidBoard(board, geometry.rows, geometry.columns, NUM_PLAYERS, geometry.connect)) {
+        printf("Invalid board\n");
+        return 1;
+    }
+
+    if (!searchMcts(&game, &config, &result)) {
+        printf("Out of memory\n");
+        return 1;
+    }
+
+    printf("Best column: %d\n", result.bestMove);
+    printf("Win rate: %.3f\n", result.winRate);
+    printf("Visits:");
+    for (int col = 0; col < geometry.columns; col++) {
+        printf(" %lu", result.visits[col]);
+    }
+    printf("\nThreads: %d\n", threads);
+    printf("Playouts: %llu\n", result.playouts);
+    printf("Nodes: %llu\n", result.nodes);
+    printf("Time: %.3f s\n", result.seconds);
+    printf("Playouts/sec: %.0f\n", result.seconds > 0 ? result.playouts / result.seconds : 0.0);
+    return 0;
+}
+
+/**
+ * @brief Play a tournament between two engines and print the results
+ * 
+ * @param first Specification of engine 0, such as "mcts:2000" or "random"
+ * @param second Specification of engine 1
+ * @param games Number of games
+ * @param threads Number of games played at once
+ * @param seed Tournament seed
+ * @param path File to write every game to, or NULL
+ * @return 0 on success, 1 if an engine or file is invalid or memory ran out
+ */
+int runTournamentMode(const char *first, const char *second, int games, int threads, uint64_t seed, const char *path) {
+
+    Engine engines[2];
+    TournamentStats stats;
+
+    if (!parseEngine(first, &engines[0]) || !parseEngine(second, &engines[1])) {
+        printf("Unknown engine %s\n", parseEngine(first, &engines[0]) ? second : first);
+        return 1;
+    }
+    if (games <= 0) {
+        printf("Invalid number of games\n");
+        return 1;
+    }
+
+    GameRecord *records = (GameRecord *) malloc(games * sizeof(GameRecord));
+    if (records == NULL) {
+        printf("Out of memory\n");
+        return 1;
+    }
+
+    if (!runTournament(engines, games, threads, seed, records, &stats)) {
+        printf("An engine failed to move\n");
+        free(records);
+        return 1;
+    }
+
+    // A game file is appended to, a text file is rewritten
+    size_t extension = strlen(GAME_FILE_EXTENSION);
+    int binary = path != NULL && strlen(path) > extension && strcmp(path + strlen(path) - extension, GAME_FILE_EXTENSION) == 0;
+
+    if (path != NULL) {
+        FILE *file = binary ? openGameWriter(path) : fopen(path, "w");
+        int written = file != NULL;
+
+        for (int i = 0; written && i < games; i++) {
+            if (binary) {
+                written = appendGame(file, records[i].columns, records[i].moves);
+            } else {
+                writeGameRecord(file, i, &records[i], engines);
+            }
+        }
+        if (file != NULL) {
+            fclose(file);
+        }
+        if (!written) {
+            printf("Cannot write %s\n", path);
+            free(records);
+            return 1;
+        }
+    }
+
+    printf("%s vs %s\n", engines[0].name, engines[1].name);
+    printf("Games: %d\n", stats.games);
+    printf("W/D/L: %d/%d/%d\n", stats.wins, stats.draws, stats.losses);
+    printf("Score: %.3f\n", stats.score);
+    printf("Elo: %+.1f +/- %.1f\n", stats.elo, stats.eloError);
+    printf("Time/move: %.3f ms / %.3f ms\n", stats.moveTime[0] * 1000, stats.moveTime[1] * 1000);
+    printf("Time: %.3f s\n", stats.seconds);
+
+    free(records);
+    return 0;
+}
+
+/**
+ * @brief Serve games to clients of a Unix domain socket until interrupted
+ * 
+ * @param path Path of the socket file
+ * @param workers Number of threads computing engine replies
+ * @return 0 after a clean stop, 1 if the socket could not be opened
+ */
+int runServe(const char *path, int workers) {
+
+    if (workers < 1) {
+        printf("Invalid number of workers\n");
+        return 1;
+    }
+
+    fprintf(stderr, "Serving on %s\n", path);
+    if (!runServer(path, workers)) {
+        printf("Cannot serve on %s\n", path);
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Build a tablebase file, or check every position of one with `isValidBoard`
+ * 
+ * @param action "build" or "check"
+ * @param path Path of the tablebase file
+ * @param threads Number of threads
+ * @param megabytes Working memory of a build
+ * @return 0 on success, 1 on failure or if a checked position is invalid
+ */
+int runTablebase(const char *action, const char *path, int threads, int megabytes) {
+
+    if (strcmp(action, "build") == 0) {
+        TablebaseStats stats;
+
+        if (megabytes <= 0 || !buildTablebase(path, threads, (size_t) megabytes << 20, &stats)) {
+            printf("Cannot build %s\n", path);
+            return 1;
+        }
+
+        printf("Positions: %llu\n", (unsigned long long) stats.count);
+        printf("Runs: %llu\n", (unsigned long long) stats.runs);
+        printf("Score: %d\n", stats.score);
+        printf("Time: %.3f s\n", stats.seconds);
+        return 0;
+    }
+
+    if (strcmp(action, "check") != 0) {
+        printf("Unknown action %s\n", action);
+        return 1;
+    }
+
+    Tablebase *tablebase = openTablebase(path);
+    uint64_t invalid;
+
+    if (tablebase == NULL) {
+        printf("Invalid tablebase\n");
+        return 1;
+    }
+
+    double start = getTime();
+    int ok = checkTablebase(tablebase, threads, &invalid);
+    printf("Positions: %llu\n", (unsigned long long) tablebase->count);
+    printf("Invalid: %llu\n", (unsigned long long) invalid);
+    printf("Time: %.3f s\n", getTime() - start);
+
+    closeTablebase(tablebase);
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief Build an opening book file
+ * 
+ * @param depth Deepest ply to store
+ * @param path Path of the book file to write
+ * @param threads Number of search threads used to solve the deepest ply
+ * @return 0 on success, 1 on failure
+ */
+int runBook(int depth, const char *path, int threads) {
+
+    Solver *solver = makeSolver();
+
+    // Check for failed allocation
+    if (solver == NULL) {
+        printf("Out of memory\n");
+        return 1;
+    }
+    setSolverThreads(solver, threads);
+
+    double start = getTime();
+    int ok = buildBook(solver, depth, path);
+    freeSolver(solver);
+
+    if (!ok) {
+        printf("Could not build the book\n");
+        return 1;
+    }
+
+    printf("Book written to %s in %.1f s\n", path, getTime() - start);
+    return 0;
+}
+
+/**
+ * @brief Count the continuations of an encoded board and print the throughput
+ * 
+ * @param code The board in the `encode()` format
+ * @param depth Plies to play
+ * @param threads Number of threads
+ * @param mode "game" to search the bitboards, "board" to search the character board,
+ *             "unique" to count distinct positions instead of continuations
+ * @return 0 on success, 1 if the board or mode is invalid or memory ran out
+ */
+int runPerft(const char *code, int depth, int threads, const char *mode) {
+
+    char board[MAX_ROWS][MAX_COLS];
+    Game game;
+    PerftResult result;
+    int ok;
+
+    // Perft starts from a legal position
+    if (!isWellFormedCode(code, geometry.rows, geometry.columns)) {
+        printf("Invalid board\n");
+        return 1;
+    }
+    initBoard(board, geometry.rows, geometry.columns);
+    decode(code, board);
+    if (!loadGame(&game, board, geometry.rows, geometry.columns) ||
+        !isValidBoard(board, geometry.rows, geometry.columns, NUM_PLAYERS, geometry.connect) || depth < 0) {
+        printf("Invalid board\n");
+        return 1;
+    }
+
+    // A game that is already over has no continuations
+    for (int i = 0; i < NUM_PLAYERS; i++) {
+        if (hasConnect(game.disks[i], geometry.connect)) {
+            printf("Game is over\n");
+            return 1;
+        }
+    }
+
+    if (strcmp(mode, "unique") == 0) {
+        ok = countUniquePositions(&game, depth, &result);
+    } else if (strcmp(mode, "board") == 0) {
+        ok = runPerftSearch(&game, depth, threads, PERFT_BOARD, &result);
+    } else if (strcmp(mode, "game") == 0) {
+        ok = runPerftSearch(&game, depth, threads, PERFT_GAME, &result);
+    } else {
+        printf("Unknown mode %s\n", mode);
+        return 1;
+    }
+
+    if (!ok) {
+        printf("Out of memory\n");
+        return 1;
+    }
+
+    printf("%s %d: %llu\n", strcmp(mode, "unique") == 0 ? "Positions" : "Perft", depth, result.leaves);
+    printf("Nodes: %llu\n", result.nodes);
+    printf("Time: %.3f s\n", result.seconds);
+    printf("Nodes/sec: %.0f\n", result.seconds > 0 ? result.nodes / result.seconds : 0.0);
+    return 0;
+}
+
+/**
+ * @brief Print the position key of an encoded board
+ * 
+ * @param code The board in the `encode()` format
+ * @return 0 on success, 1 if the board has a floating disk
+ */
+int runKey(const char *code) {
+
+    PositionKey key;
+    char text[KEY_TEXT_LENGTH];
+
+    if (!codeToKey(code, &key)) {
+        printf("Invalid board\n");
+        return 1;
+    }
+
+    formatKey(key, text);
+    printf("%s\n", text);
+    return 0;
+}
+
+/**
+ * @brief Print the encoded board of a position key
+ * 
+ * @param hexKey The position key as a hexadecimal string
+ * @return 0 on success, 1 if the key is malformed
+ */
+int runCode(const char *hexKey) {
+
+    char code[2 * MAX_ROWS * MAX_COLS + MAX_ROWS + 1];
+    PositionKey key;
+
+    if (!parseKey(hexKey, &key) || !keyToCode(key, code)) {
+        printf("Invalid key\n");
+        return 1;
+    }
+
+    printf("%s\n", code);
+    return 0;
+}
+
+/**
+ * @brief Validate a stream of encoded boards, one per line
+ * 
+ * Prints 1 or 0 per line on the standard output and a summary on the
+ * standard error.
+ * 
+ * @param path The file to read, or "-" for the standard input
+ * @param players Players taking turns on the boards
+ * @param threads Number of worker threads
+ * @return 0 on success, 1 if the file cannot be read or memory ran out
+ */
+int runValidate(const char *path, int players, int threads) {
+
+    FILE *input = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    BulkStats stats;
+
+    if (input == NULL) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return 1;
+    }
+
+    int ok = validateStream(input, stdout, players, threads, &stats);
+    if (input != stdin) {
+        fclose(input);
+    }
+    if (!ok) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    fprintf(stderr, "Boards: %llu\nValid: %llu\nTime: %.3f s\n", stats.boards, stats.valid, stats.seconds);
+    if (stats.seconds > 0) {
+        fprintf(stderr, "Speed: %.0f boards/s\n", stats.boards / stats.seconds);
+    }
+    return 0;
+}
+
+/**
+ * @brief Write a corpus of random boards and print how it was made
+ * 
+ * The boards go to the file, or to the standard output, one encoded board
+ * per line; the counts are printed on the standard error.
+ * 
+ * @param count Number of boards
+ * @param kindName "legal", "floating", "turns", "double" or "mixed"
+ * @param threads Number of generator threads
+ * @param seed Corpus seed
+ * @param path The file to write, or "-" for the standard output
+ * @return 0 on success, 1 if an argument is invalid, the file cannot be written or memory ran out
+ */
+int runGenerate(long long count, const char *kindName, int threads, uint64_t seed, const char *path) {
+
+    int kind = parseBoardKind(kindName);
+    GeneratorStats stats;
+
+    if (count < 0 || kind < 0) {
+        fprintf(stderr, "Invalid count or kind\n");
+        return 1;
+    }
+
+    FILE *output = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    if (output == NULL) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return 1;
+    }
+
+    int ok = generateBoards(output, (uint64_t) count, kind, threads, seed, &stats);
+    if (output != stdout && fclose(output) != 0) {
+        ok = 0;
+    }
+    if (!ok && stats.failed > 0) {
+        fprintf(stderr, "Cannot generate %s boards on this board geometry\n", kindName);
+        return 1;
+    }
+    if (!ok) {
+        fprintf(stderr, "Cannot write the boards\n");
+        return 1;
+    }
+
+    fprintf(stderr, "Boards: %llu (legal %llu, floating %llu, turns %llu, double win %llu)\n",
+            (unsigned long long) stats.boards, (unsigned long long) stats.kinds[GENERATE_LEGAL],
+            (unsigned long long) stats.kinds[GENERATE_FLOATING], (unsigned long long) stats.kinds[GENERATE_TURNS],
+            (unsigned long long) stats.kinds[GENERATE_DOUBLE_WIN]);
+    fprintf(stderr, "Retries: %llu\nTime: %.3f s\n", (unsigned long long) stats.retries, stats.seconds);
+    if (stats.seconds > 0) {
+        fprintf(stderr, "Speed: %.0f boards/s\n", stats.boards / stats.seconds);
+    }
+    return 0;
+}
+
+/**
+ * @brief Pack a file of encoded boards, one per line, into a record archive
+ * 
+ * @param input The file to read, or "-" for the standard input
+ * @param path The archive to write
+ * @return 0 on success, 1 if a file cannot be used or a line is not a storable board
+ */
+int runPack(const char *input, const char *path) {
+
+    FILE *in = strcmp(input, "-") == 0 ? stdin : fopen(input, "r");
+    FILE *out = fopen(path, "wb");
+    uint64_t count;
+
+    if (in == NULL || out == NULL) {
+        fprintf(stderr, "Cannot open %s\n", in == NULL ? input : path);
+        if (in != NULL && in != stdin) {
+            fclose(in);
+        }
+        if (out != NULL) {
+            fclose(out);
+        }
+        return 1;
+    }
+
+    int ok = packCodes(in, out, &count);
+    ok = fclose(out) == 0 && ok;
+    if (in != stdin) {
+        fclose(in);
+    }
+    if (!ok) {
+        fprintf(stderr, "Cannot pack line %llu\n", (unsigned long long) count + 1);
+        remove(path);
+        return 1;
+    }
+
+    fprintf(stderr, "Records: %llu\nBytes per record: %d\n", (unsigned long long) count, getRecordSize());
+    return 0;
+}
+
+/**
+ * @brief Print every board of a record archive in the `encode()` format
+ * 
+ * @param path The archive to read
+ * @return 0 on success, 1 if the archive cannot be used
+ */
+int runUnpack(const char *path) {
+
+    RecordArchive *archive = openArchive(path);
+
+    if (archive == NULL) {
+        fprintf(stderr, "Cannot open archive %s\n", path);
+        return 1;
+    }
+
+    int ok = unpackArchive(archive, stdout);
+    closeArchive(archive);
+    if (!ok) {
+        fprintf(stderr, "Corrupt archive %s\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Replay every game of a game file and print the results and the replay speed
+ * 
+ * @param path Path of the game file
+ * @param threads Number of replay threads
+ * @param method "game" to replay on the Game bitboards, "board" to replay through `playMove`
+ * @return 0 if every game is valid, 1 otherwise or if the file cannot be read
+ */
+int runReplay(const char *path, int threads, const char *method) {
+
+    ReplayStats stats;
+    int replayMethod = strcmp(method, "board") == 0 ? REPLAY_BOARD : REPLAY_GAME;
+
+    if (strcmp(method, "game") != 0 && strcmp(method, "board") != 0) {
+        printf("Unknown replay method %s\n", method);
+        return 1;
+    }
+
+    GameFile *file = openGameFile(path);
+    if (file == NULL) {
+        fprintf(stderr, "Cannot open game file %s\n", path);
+        return 1;
+    }
+
+    int ok = replayGames(file, threads, replayMethod, NULL, NULL, &stats);
+    if (file->truncated) {
+        printf("The last game is cut short and was skipped\n");
+    }
+    closeGameFile(file);
+
+    printf("Games: %llu\n", (unsigned long long) stats.games);
+    printf("Plies: %llu\n", (unsigned long long) stats.plies);
+    printf("Wins:");
+    for (int player = 0; player < NUM_PLAYERS; player++) {
+        printf(" %c %llu", 'A' + player, (unsigned long long) stats.wins[player]);
+    }
+    printf("\nTies: %llu\n", (unsigned long long) stats.ties);
+    printf("Unfinished: %llu\n", (unsigned long long) stats.unfinished);
+    printf("Invalid: %llu\n", (unsigned long long) stats.invalid);
+    printf("Time: %.3f s\n", stats.seconds);
+    printf("Games/sec: %.0f\n", stats.seconds > 0 ? stats.games / stats.seconds : 0.0);
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief Compare the table-driven codec with the original one and print their throughput
+ * 
+ * @param boards Number of random boards to convert
+ * @return 0 if both codecs agree on every board, 1 otherwise or if memory ran out
+ */
+int runCodec(int boards) {
+
+    const int ROUNDS = 10;
+    CodecStats stats;
+
+    if (boards <= 0 || !benchmarkCodec((size_t) boards, ROUNDS, &stats)) {
+        printf("Cannot run the benchmark\n");
+        return 1;
+    }
+
+    double conversions = (double) stats.boards * stats.rounds;
+    printf("Boards: %zu x %d\n", stats.boards, stats.rounds);
+    printf("Encode: %.0f boards/s (original %.0f boards/s)\n",
+           conversions / stats.tableEncode, conversions / stats.referenceEncode);
+    printf("Decode: %.0f boards/s (original %.0f boards/s)\n",
+           conversions / stats.tableDecode, conversions / stats.referenceDecode);
+    printf("Identical: %s\n", stats.identical ? "yes" : "no");
+    return stats.identical ? 0 : 1;
+}
+
+/**
+ * @brief Print the command-line usage
+ * 
+ * @param program Name the program was started with
+ */
+void printUsage(const char *program) {
+
+    fprintf(stderr,
+            "Usage: %s [--size <columns>x<rows>] [--connect <n>] [--players <n>] [mode]\n"
+            "Modes:\n"
+            "  solve <code> [threads] [book]\n"
+            "  search <code> <milliseconds> [threads]\n"
+            "  versus <milliseconds> [A|B] [threads] [file]\n"
+            "  mcts <code> [budget] [threads]\n"
+            "  tournament <engine> <engine> <games> [threads] [seed] [file]\n"
+            "  serve <socket> [workers]\n"
+            "  book <depth> <file> [threads]\n"
+            "  tablebase build <file> [threads] [megabytes]\n"
+            "  tablebase check <file> [threads]\n"
+            "  perft <code> <depth> [threads] [game|board|unique]\n"
+            "  key <code>\n"
+            "  code <key>\n"
+            "  validate [file|-] [threads]\n"
+            "  generate <count> [kind] [threads] [seed] [file|-]\n"
+            "  pack <file|-> <archive>\n"
+            "  unpack <archive>\n"
+            "  codec [boards]\n"
+            "  play <file>\n"
+            "  replay <file> [threads] [game|board]\n"
+            "Without a mode the game is played in the terminal.\n",
+            program);
 }
 
 /**
  * @brief Main function
  * 
- * This is the entry point of the program. It starts the game by calling
- * the run() function which handles the game loop.
+ * This is the entry point of the program. Without a mode it plays the game in
+ * the terminal, otherwise it runs the tool listed by printUsage().
  */
-int main() {
-    run(); // Start the Connect-style game
+int main(int argc, char *argv[]) {
+
+    START_PROBES();
+    int rows = DEFAULT_ROWS;
+    int columns = DEFAULT_COLS;
+    int connect = DEFAULT_CONNECT;
+    int players = NUM_PLAYERS;
+
+    // Consume the geometry options and shift the mode arguments down
+    while (argc >= 3 && (strcmp(argv[1], "--size") == 0 || strcmp(argv[1], "--connect") == 0 ||
+                         strcmp(argv[1], "--players") == 0)) {
+        if (strcmp(argv[1], "--connect") == 0) {
+            connect = atoi(argv[2]);
+        } else if (strcmp(argv[1], "--players") == 0) {
+            players = atoi(argv[2]);
+        } else if (sscanf(argv[2], "%dx%d", &columns, &rows) != 2) {
+            fprintf(stderr, "Invalid size %s\n", argv[2]);
+            return 1;
+        }
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+
+    if (!setGeometry(rows, columns, connect)) {
+        fprintf(stderr, "Unsupported geometry %dx%d connect %d\n", columns, rows, connect);
+        return 1;
+    }
+
+    // The engines, books and file formats are for two players
+    if (players < NUM_PLAYERS || players > MAX_PLAYERS ||
+        (players != NUM_PLAYERS && argc >= 2 && strcmp(argv[1], "validate") != 0)) {
+        fprintf(stderr, "Unsupported number of players %d\n", players);
+        return 1;
+    }
+
+    if (argc >= 3 && argc <= 5 && strcmp(argv[1], "solve") == 0) {
+        return runSolve(argv[2], argc >= 4 ? atoi(argv[3]) : 1, argc == 5 ? argv[4] : NULL);
+    }
+    if (argc >= 4 && argc <= 5 && strcmp(argv[1], "search") == 0) {
+        return runSearch(argv[2], atoi(argv[3]), argc == 5 ? atoi(argv[4]) : 1);
+    }
+    if (argc >= 3 && argc <= 6 && strcmp(argv[1], "versus") == 0) {
+        return runVersus(atoi(argv[2]), argc >= 4 ? argv[3][0] : 'B', argc >= 5 ? atoi(argv[4]) : 1,
+                         argc == 6 ? argv[5] : NULL);
+    }
+    if (argc >= 3 && argc <= 5 && strcmp(argv[1], "mcts") == 0) {
+        return runMcts(argv[2], argc >= 4 ? argv[3] : "100000", argc == 5 ? atoi(argv[4]) : 1);
+    }
+    if (argc >= 5 && argc <= 8 && strcmp(argv[1], "tournament") == 0) {
+        return runTournamentMode(argv[2], argv[3], atoi(argv[4]), argc >= 6 ? atoi(argv[5]) : 1,
+                                 argc >= 7 ? strtoull(argv[6], NULL, 10) : 1, argc == 8 ? argv[7] : NULL);
+    }
+    if ((argc == 3 || argc == 4) && strcmp(argv[1], "serve") == 0) {
+        return runServe(argv[2], argc == 4 ? atoi(argv[3]) : 1);
+    }
+    if (argc >= 4 && argc <= 6 && strcmp(argv[1], "tablebase") == 0) {
+        return runTablebase(argv[2], argv[3], argc >= 5 ? atoi(argv[4]) : 1,
+                            argc == 6 ? atoi(argv[5]) : TABLEBASE_DEFAULT_MEMORY);
+    }
+    if ((argc == 4 || argc == 5) && strcmp(argv[1], "book") == 0) {
+        return runBook(atoi(argv[2]), argv[3], argc == 5 ? atoi(argv[4]) : 1);
+    }
+    if (argc >= 4 && argc <= 6 && strcmp(argv[1], "perft") == 0) {
+        return runPerft(argv[2], atoi(argv[3]), argc >= 5 ? atoi(argv[4]) : 1, argc == 6 ? argv[5] : "game");
+    }
+    if (argc == 3 && strcmp(argv[1], "key") == 0) {
+        return runKey(argv[2]);
+    }
+    if (argc == 3 && strcmp(argv[1], "code") == 0) {
+        return runCode(argv[2]);
+    }
+    if (argc >= 2 && argc <= 4 && strcmp(argv[1], "validate") == 0) {
+        return runValidate(argc >= 3 ? argv[2] : "-", players, argc == 4 ? atoi(argv[3]) : 1);
+    }
+    if (argc >= 3 && argc <= 7 && strcmp(argv[1], "generate") == 0) {
+        return runGenerate(atoll(argv[2]), argc >= 4 ? argv[3] : "legal", argc >= 5 ? atoi(argv[4]) : 1,
+                           argc >= 6 ? strtoull(argv[5], NULL, 10) : 1, argc == 7 ? argv[6] : "-");
+    }
+    if (argc == 4 && strcmp(argv[1], "pack") == 0) {
+        return runPack(argv[2], argv[3]);
+    }
+    if (argc == 3 && strcmp(argv[1], "unpack") == 0) {
+        return runUnpack(argv[2]);
+    }
+    if ((argc == 2 || argc == 3) && strcmp(argv[1], "codec") == 0) {
+        return runCodec(argc == 3 ? atoi(argv[2]) : 100000);
+    }
+
+    if (argc >= 3 && argc <= 5 && strcmp(argv[1], "replay") == 0) {
+        return runReplay(argv[2], argc >= 4 ? atoi(argv[3]) : 1, argc == 5 ? argv[4] : "game");
+    }
+    if (argc == 3 && strcmp(argv[1], "play") == 0) {
+        FILE *gameFile = openGameWriter(argv[2]);
+        if (gameFile == NULL) {
+            fprintf(stderr, "Cannot open game file %s\n", argv[2]);
+            return 1;
+        }
+        run(gameFile, NUM_PLAYERS, NULL, 0, 0);
+        fclose(gameFile);
+        return 0;
+    }
+
+    if (argc >= 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    run(NULL, players, NULL, 0, 0); // Start the Connect-style game
     return 0; // Exit the program successfully
 }
@@ -2,33 +2,70 @@
  * @file 4InARow.h
  * @brief Header file for 4InARow.c
  */
-#define ROWS 6
-#define COLS 7
-#define NUM_PLAYERS 2
-#define CONNECT 4
+#ifndef FOUR_IN_A_ROW_H
+#define FOUR_IN_A_ROW_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MAX_ROWS 9          // Capacity of a board array, the geometry itself is set at runtime
+#define MAX_COLS 9
+#define DEFAULT_ROWS 6
+#define DEFAULT_COLS 7
+#define DEFAULT_CONNECT 4
+#define NUM_PLAYERS 2          // Players of the engines and the file formats
+#define MAX_PLAYERS 4          // Most players a board can be checked or played with
 #define EMPTY_POS ' '
 #define INVALID_BOARD 0
 #define VALID_BOARD 1
+#define GAME_WON 1
+#define GAME_TIE 0
+#define GAME_ON -1
+#define MOVE_FAILED -2
+#define DEAD_END_BITS 9                    // log2 of the dead-end slots isValidBoard keeps on the stack
+#define DEAD_END_SLOTS (1 << DEAD_END_BITS)
+#define REPLAY_UNDECIDED -1                // The replay ran out of steps before it found an answer
+
+/**
+ * @brief The states of a replay known to lead nowhere
+ *
+ * A state is the number of disks dropped in every column, numbered in mixed
+ * radix. The first dead ends go into a small table on the stack; if it
+ * fills up, they move to a bitmap with one bit per state, so no dead end is
+ * ever forgotten.
+ */
+typedef struct DeadEnds {
+    uint64_t *bits;                  // One bit per state once `local` is full, NULL before
+    size_t states;                   // Number of states of the replay
+    size_t used;                     // Number of dead ends in `local`
+    uint64_t local[DEAD_END_SLOTS];  // A state is stored as state + 1, 0 marks a free slot
+} DeadEnds;
 
-int getBottomEmptyPos(char board[ROWS][COLS],int rows, int column);
+int getBottomEmptyPos(char board[MAX_ROWS][MAX_COLS],int rows, int column);
 int validatePositions (int col, int row, int columns, int rows, int connect,int action);
-int getNumOfConnects(char board[ROWS][COLS], int connect, int rows, int columns, int countArr[], int col, int row,char\
-                     player, int directions,int originalConnect, int toValidate);
-int checkForConnect(char board[ROWS][COLS], int connect, int rows, int columns,int validate,int player);
-int checkForFullBoard(char board[ROWS][COLS], int columns);
+int checkForConnect(const char board[MAX_ROWS][MAX_COLS], int connect, int rows, int columns, int validate, int player);
+int checkForFullBoard(char board[MAX_ROWS][MAX_COLS], int columns);
 int isValidPlayer (int players, int player);
-int getNumOfOccurences(char board[ROWS][COLS], int rows, int columns, char player);
-int validatePlayTimes(char board[ROWS][COLS], int rows, int columns, int players);
-int validatePlayMoves(char board[ROWS][COLS], int rows, int columns, int lastPlayed, int numOfOccur, int players);
-int validatePlays(char board[ROWS][COLS], int rows, int columns, int players);
+int getNumOfOccurrences(char board[MAX_ROWS][MAX_COLS], int rows, int columns, char player);
+int canReplayStacks(int stacks[MAX_COLS][MAX_ROWS], const int heights[MAX_COLS], int columns, int players, int disks);
+int replayStacksWithin(int stacks[MAX_COLS][MAX_ROWS], const int heights[MAX_COLS], int columns, int players, int disks,
+                       DeadEnds *deadEnds, long steps);
+int isDeadEnd(const DeadEnds *deadEnds, uint64_t state);
+int addDeadEnd(DeadEnds *deadEnds, uint64_t state);
 int get64BaseAsInteger(char input);
 
-void initBoard(char board[ROWS][COLS], int rows, int columns);
-void printBoard(char board[ROWS][COLS], int rows, int columns);
-int makeMove(char board[ROWS][COLS], int rows, int columns, int players, char player, int column);
-int undoMove(char board[ROWS][COLS], int rows, int columns, int column);
-int getStatus(char board[ROWS][COLS], int rows, int columns, int players, int connect);
-char getWinner(char board[ROWS][COLS], int rows, int columns, int players, int connect);
-int isValidBoard(char board[ROWS][COLS], int rows, int columns, int players, int connect);
-void encode(const char board[ROWS][COLS], int rows, int cols, char *code);
-void decode(const char *code, char board[ROWS][COLS]);
\ No newline at end of file
+void initBoard(char board[MAX_ROWS][MAX_COLS], int rows, int columns);
+void printBoard(char board[MAX_ROWS][MAX_COLS], int rows, int columns);
+int makeMove(char board[MAX_ROWS][MAX_COLS], int rows, int columns, int players, char player, int column);
+int undoMove(char board[MAX_ROWS][MAX_COLS], int rows, int columns, int column);
+int checkLastMove(char board[MAX_ROWS][MAX_COLS], int rows, int columns, int connect, int row, int column);
+int playMove(char board[MAX_ROWS][MAX_COLS], int rows, int columns, int players, int connect, char player, int column,
+             int *movesPlayed);
+int getStatus(char board[MAX_ROWS][MAX_COLS], int rows, int columns, int players, int connect);
+char getWinner(char board[MAX_ROWS][MAX_COLS], int rows, int columns, int players, int connect);
+int isValidBoard(const char board[MAX_ROWS][MAX_COLS], int rows, int columns, int players, int connect);
+void encode(const char board[MAX_ROWS][MAX_COLS], int rows, int cols, char *code);
+void decode(const char *code, char board[MAX_ROWS][MAX_COLS]);
+
+#endif
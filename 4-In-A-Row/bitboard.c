@@ -0,0 +1,428 @@
+#include "bitboard.h"
+#include "boardStats.h"
+#include "instrument.h"
+
+/**
+ * @brief Check if a bitboard holds `connect` disks in a line
+ *
+ * For every direction the bitboard is ANDed with copies of itself shifted
+ * by one cell along that direction. A bit that survives `connect - 1`
+ * shifts starts a full line. The sentinel row stops lines from wrapping
+ * around between columns. A direction in which `connect` cells would span
+ * the whole word holds no line on any board and is skipped. Called with
+ * constant arguments, the compiler unrolls every loop.
+ *
+ * @param disks The disks of a single player
+ * @param height Bits per column
+ * @param connect Number of disks in a row required to win
+ * @return 1 if a line was found, 0 otherwise
+ */
+static inline int findConnect(Bitboard disks, int height, int connect) {
+
+    // Vertical, horizontal, and the two diagonals
+    const int shifts[4] = {1, height, height - 1, height + 1};
+
+    for (int dir = 0; dir < 4; dir++) {
+        // A line spanning the whole word cannot fit on the board, and the shift would overflow
+        if ((connect - 1) * shifts[dir] >= BITBOARD_BITS) {
+            continue;
+        }
+
+        Bitboard run = disks;
+
+        // Keep only the disks followed by `step` more disks in this direction
+        for (int step = 1; step < connect; step++) {
+            run &= disks >> (step * shifts[dir]);
+        }
+
+        if (run) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Count the winning windows filled by every player in one pass
+ *
+ * Windows with an empty cell are skipped with a single test, whatever the
+ * number of players.
+ *
+ * @param pos The position
+ * @param players Number of players to count, at most MAX_PLAYERS
+ * @param wins Filled with the number of windows of every player
+ * @param common Filled with the cells shared by all windows of every player, the board for none
+ * @return Number of players with at least one window
+ */
+int countWins(const BitPosition *pos, int players, int wins[MAX_PLAYERS], Bitboard common[MAX_PLAYERS]) {
+
+    PROBE(PROBE_COUNT_WINS);
+    int winners = 0;
+
+    for (int player = 0; player < players; player++) {
+        wins[player] = 0;
+        common[player] = BB_BOARD_MASK;
+    }
+
+    for (int i = 0; i < geometry.windowCount; i++) {
+        Bitboard window = geometry.windows[i];
+
+        if ((pos->mask & window) != window) {
+            continue; // Not full, so nobody owns it
+        }
+
+        for (int player = 0; player < players; player++) {
+            if ((pos->disks[player] & window) == window) {
+                winners += wins[player]++ == 0;
+                common[player] &= window;
+                break;
+            }
+        }
+    }
+
+    return winners;
+}
+
+/**
+ * @brief Find the empty cells that would complete a line for a player
+ *
+ * For every direction and every position of the missing disk inside a
+ * line, the player's bitboard is shifted so that the other `connect - 1`
+ * disks of the line land on the missing cell, and the copies are ANDed.
+ * Steps that leave the board land on a sentinel bit, which is never set.
+ *
+ * @param disks The disks of a single player
+ * @param mask Every occupied cell
+ * @param boardMask Every cell of the board
+ * @param height Bits per column
+ * @param connect Number of disks in a row required to win
+ * @return A bitboard of the empty cells that complete a line
+ */
+static inline Bitboard findWinningCells(Bitboard disks, Bitboard mask, Bitboard boardMask, int height, int connect) {
+
+    const int shifts[4] = {1, height, height - 1, height + 1};
+    Bitboard cells = 0;
+
+    for (int dir = 0; dir < 4; dir++) {
+        if ((connect - 1) * shifts[dir] >= BITBOARD_BITS) {
+            continue; // No line this long fits on the board
+        }
+
+        // Try every position of the missing disk inside the line
+        for (int gap = 0; gap < connect; gap++) {
+            Bitboard line = boardMask;
+
+            for (int i = 0; i < connect; i++) {
+                int offset = (i - gap) * shifts[dir];
+
+                if (offset > 0) {
+                    line &= disks >> offset;
+                } else if (offset < 0) {
+                    line &= disks << -offset;
+                }
+            }
+            cells |= line;
+        }
+    }
+
+    // Only empty cells can still be played
+    return cells & (boardMask ^ mask);
+}
+
+/**
+ * Kernels compiled for one exact geometry: every shift and mask is a
+ * constant, so the line searches are fully unrolled.
+ */
+#define DEFINE_KERNELS(NAME, ROWS, COLUMNS, CONNECT)                                              \
+    static int hasConnect##NAME(Bitboard disks) {                                                 \
+        return findConnect(disks, (ROWS) + 1, CONNECT);                                           \
+    }                                                                                             \
+    static Bitboard getWinningCells##NAME(Bitboard disks, Bitboard mask) {                        \
+        return findWinningCells(disks, mask, LAYOUT_BOARD_MASK(ROWS, COLUMNS), (ROWS) + 1, CONNECT); \
+    }
+
+DEFINE_KERNELS(7x6, 6, 7, 4)
+DEFINE_KERNELS(8x7, 7, 8, 4)
+DEFINE_KERNELS(9x6, 6, 9, 5)
+#ifdef WIDE_BITBOARD
+DEFINE_KERNELS(9x7, 7, 9, 4)
+#endif
+
+typedef struct Kernels {
+    int rows;
+    int columns;
+    int connect;
+    int (*hasConnect)(Bitboard disks);
+    Bitboard (*getWinningCells)(Bitboard disks, Bitboard mask);
+} Kernels;
+
+static const Kernels specializedKernels[] = {
+    {6, 7, 4, hasConnect7x6, getWinningCells7x6},
+    {7, 8, 4, hasConnect8x7, getWinningCells8x7},
+    {6, 9, 5, hasConnect9x6, getWinningCells9x6},
+#ifdef WIDE_BITBOARD
+    {7, 9, 4, hasConnect9x7, getWinningCells9x7},
+#endif
+};
+
+/**
+ * @brief Generic line search for the current geometry
+ * @param disks The disks of a single player
+ * @return 1 if a line was found, 0 otherwise
+ */
+static int hasConnectAny(Bitboard disks) {
+    return findConnect(disks, geometry.height, geometry.connect);
+}
+
+/**
+ * @brief Generic threat search for the current geometry
+ * @param disks The disks of a single player
+ * @param mask Every occupied cell
+ * @return A bitboard of the empty cells that complete a line
+ */
+static Bitboard getWinningCellsAny(Bitboard disks, Bitboard mask) {
+    return findWinningCells(disks, mask, geometry.boardMask, geometry.height, geometry.connect);
+}
+
+// The classic 7x6 connect-4 board until setGeometry is called
+Geometry geometry = {
+    DEFAULT_ROWS, DEFAULT_COLS, DEFAULT_CONNECT, DEFAULT_ROWS * DEFAULT_COLS,
+    DEFAULT_ROWS + 1, (DEFAULT_ROWS + 1) * DEFAULT_COLS,
+    LAYOUT_ALL_BITS(DEFAULT_ROWS, DEFAULT_COLS),
+    LAYOUT_BOTTOM_MASK(DEFAULT_ROWS, DEFAULT_COLS),
+    LAYOUT_BOARD_MASK(DEFAULT_ROWS, DEFAULT_COLS),
+    hasConnect7x6, getWinningCells7x6,
+    0, {0}, {0} // The windows and row cells are filled by setGeometry
+};
+
+/**
+ * @brief List every winning window of the current geometry
+ *
+ * A window is `connect` cells in a line: up a column, along a row or on
+ * either diagonal. Each one is listed once, from the cell where it starts.
+ */
+static void buildWindows(void) {
+
+    // Column and row steps of the four directions, rows counted from the bottom
+    const int colSteps[4] = {0, 1, 1, 1};
+    const int rowSteps[4] = {1, 0, 1, -1};
+    const int span = geometry.connect - 1;
+
+    geometry.windowCount = 0;
+    for (int dir = 0; dir < 4; dir++) {
+        for (int col = 0; col + colSteps[dir] * span < geometry.columns; col++) {
+            for (int row = 0; row < geometry.rows; row++) {
+                int endRow = row + rowSteps[dir] * span;
+                if (endRow < 0 || endRow >= geometry.rows) {
+                    continue;
+                }
+
+                Bitboard window = 0;
+                for (int step = 0; step <= span; step++) {
+                    window |= (Bitboard) 1 << ((col + colSteps[dir] * step) * geometry.height + row + rowSteps[dir] * step);
+                }
+                geometry.windows[geometry.windowCount++] = window;
+            }
+        }
+    }
+}
+
+/**
+ * @brief List the bottom-row cells of every set of columns
+ *
+ * Bit `col` of a set selects the bottom cell of column `col`, so a row of
+ * a character board matched into such a set becomes bitboard cells with one
+ * lookup and a shift by its height.
+ */
+static void buildRowCells(void) {
+
+    for (unsigned set = 0; set < (1u << MAX_COLS); set++) {
+        geometry.rowCells[set] = 0;
+        for (int col = 0; col < geometry.columns; col++) {
+            if (set & (1u << col)) {
+                geometry.rowCells[set] |= (Bitboard) 1 << (col * geometry.height);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Choose the board geometry of the program
+ *
+ * Must be called before any board or game is created; boards, games,
+ * position keys and opening books of another geometry are meaningless
+ * afterwards.
+ *
+ * @param rows Number of rows, at most MAX_ROWS
+ * @param columns Number of columns, at most MAX_COLS
+ * @param connect Number of disks in a row needed to win
+ * @return 1 on success, 0 if the geometry is not supported (the current one is kept)
+ */
+int setGeometry(int rows, int columns, int connect) {
+
+    const int MIN_CONNECT = 2;
+
+    // The board and one sentinel per column must fit into a bitboard
+    if (rows < 1 || rows > MAX_ROWS || columns < 1 || columns > MAX_COLS ||
+        (rows + 1) * columns > BITBOARD_BITS ||
+        connect < MIN_CONNECT || (connect > rows && connect > columns)) {
+        return 0;
+    }
+
+    geometry.rows = rows;
+    geometry.columns = columns;
+    geometry.connect = connect;
+    geometry.cells = rows * columns;
+    geometry.height = rows + 1;
+    geometry.size = (rows + 1) * columns;
+    geometry.allBits = LAYOUT_ALL_BITS(rows, columns);
+    geometry.bottomMask = LAYOUT_BOTTOM_MASK(rows, columns);
+    geometry.boardMask = LAYOUT_BOARD_MASK(rows, columns);
+    geometry.hasConnect = hasConnectAny;
+    geometry.getWinningCells = getWinningCellsAny;
+    buildWindows();
+    buildRowCells();
+
+    // Prefer kernels compiled for this exact geometry
+    for (size_t i = 0; i < sizeof(specializedKernels) / sizeof(specializedKernels[0]); i++) {
+        const Kernels *kernels = &specializedKernels[i];
+
+        if (kernels->rows == rows && kernels->columns == columns && kernels->connect == connect) {
+            geometry.hasConnect = kernels->hasConnect;
+            geometry.getWinningCells = kernels->getWinningCells;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Get the bitboard bit of a board cell
+ *
+ * Board rows are counted from the top while bitboard columns are filled
+ * from the bottom, so the row index is flipped.
+ *
+ * @param row Row index of the cell (0 is the top row)
+ * @param column Column index of the cell
+ * @return A bitboard with only the cell's bit set
+ */
+Bitboard getCellBit(int row, int column) {
+    return (Bitboard) 1 << (column * BB_HEIGHT + (geometry.rows - 1 - row));
+}
+
+/**
+ * @brief Pack a character board into one bitboard per player
+ *
+ * Cells that do not hold one of the first `players` players are treated
+ * as empty.
+ *
+ * @param board The 2D board array to pack
+ * @param rows Number of rows in the board
+ * @param columns Number of columns in the board
+ * @param players Total number of players
+ * @param pos The position to fill
+ */
+void loadBitPosition(const char board[MAX_ROWS][MAX_COLS], int rows, int columns, int players, BitPosition *pos) {
+
+    BoardStats stats;
+
+    getBoardStats(board, rows, columns, players, &stats);
+    *pos = stats.pos;
+}
+
+/**
+ * @brief Check if a bitboard holds `connect` disks in a line
+ *
+ * Uses the kernel of the current geometry when `connect` is its own.
+ *
+ * @param disks The disks of a single player
+ * @param connect Number of disks in a row required to win
+ * @return 1 if a line was found, 0 otherwise
+ */
+int hasConnect(Bitboard disks, int connect) {
+
+    PROBE(PROBE_HAS_CONNECT);
+    if (connect == geometry.connect) {
+        return geometry.hasConnect(disks);
+    }
+
+    return findConnect(disks, BB_HEIGHT, connect);
+}
+
+/**
+ * @brief Get the cells shared by every line of `connect` disks
+ *
+ * A line is found the same way as in `hasConnect`; longer runs count as
+ * several overlapping lines. If a single disk lies on every line, removing
+ * it leaves the player without a connect.
+ *
+ * @param disks The disks of a single player
+ * @param connect Number of disks in a row required to win
+ * @return The cells that belong to every line, 0 if there is no line
+ */
+Bitboard getCommonLineCells(Bitboard disks, int connect) {
+
+    PROBE(PROBE_COMMON_LINE_CELLS);
+    const int shifts[4] = {1, BB_HEIGHT, BB_HEIGHT - 1, BB_HEIGHT + 1};
+    Bitboard common = BB_BOARD_MASK;
+    int found = 0;
+
+    // The geometry's own lines are listed in the window table
+    if (connect == geometry.connect) {
+        BitPosition pos = {{disks}, disks};
+        Bitboard shared[MAX_PLAYERS];
+        int wins[MAX_PLAYERS];
+
+        countWins(&pos, 1, wins, shared);
+        return wins[0] > 0 ? shared[0] : 0;
+    }
+
+    for (int dir = 0; dir < 4; dir++) {
+        if ((connect - 1) * shifts[dir] >= BITBOARD_BITS) {
+            continue; // No line this long fits on the board
+        }
+
+        Bitboard starts = disks;
+
+        // Keep the first disk of every line in this direction
+        for (int step = 1; step < connect && starts; step++) {
+            starts &= disks >> (step * shifts[dir]);
+        }
+
+        // Intersect the cells of every line
+        while (starts) {
+            Bitboard first = starts & (~starts + 1);
+            Bitboard line = 0;
+
+            for (int step = 0; step < connect; step++) {
+                line |= first << (step * shifts[dir]);
+            }
+            common &= line;
+            starts ^= first;
+            found = 1;
+        }
+    }
+
+    return found ? common : 0;
+}
+
+/**
+ * @brief Find the empty cells that would complete a line for a player
+ *
+ * Uses the kernel of the current geometry when `connect` is its own. The
+ * cells do not have to be playable right away.
+ *
+ * @param disks The disks of a single player
+ * @param mask Every occupied cell
+ * @param connect Number of disks in a row required to win
+ * @return A bitboard of the empty cells that complete a line
+ */
+Bitboard getWinningCells(Bitboard disks, Bitboard mask, int connect) {
+
+    if (connect == geometry.connect) {
+        return geometry.getWinningCells(disks, mask);
+    }
+
+    return findWinningCells(disks, mask, BB_BOARD_MASK, BB_HEIGHT, connect);
+}
@@ -0,0 +1,80 @@
+/**
+ * @file bitboard.h
+ * @brief Header file for bitboard.c
+ *
+ * Every player's disks are packed into one word, one column after the
+ * other. Each column takes `rows` bits (bottom row first) plus one
+ * always-empty sentinel bit on top, so shifting a bitboard never carries a
+ * line of disks from one column into the next.
+ *
+ * The board geometry is chosen at runtime with `setGeometry` and applies to
+ * the whole program. A board fits if (rows + 1) * columns bits fit into a
+ * Bitboard: 64 bits by default, or 128 bits when built with -DWIDE_BITBOARD
+ * (needed for 9x7). Common geometries get line-search kernels compiled for
+ * their exact size; any other geometry uses the generic kernels.
+ */
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <stdint.h>
+#include "4inARow.h"
+
+#ifdef WIDE_BITBOARD
+typedef unsigned __int128 Bitboard;
+#define BITBOARD_BITS 128
+#define BB_COUNT(b) (__builtin_popcountll((uint64_t) (b)) + __builtin_popcountll((uint64_t) ((b) >> 64)))
+#define BB_FIRST(b) ((uint64_t) (b) ? __builtin_ctzll((uint64_t) (b)) : 64 + __builtin_ctzll((uint64_t) ((b) >> 64)))
+#else
+typedef uint64_t Bitboard;
+#define BITBOARD_BITS 64
+#define BB_COUNT(b) __builtin_popcountll(b)
+#define BB_FIRST(b) __builtin_ctzll(b)
+#endif
+
+// Masks of a geometry known at compile time
+#define LAYOUT_ALL_BITS(rows, columns) (~(Bitboard) 0 >> (BITBOARD_BITS - ((rows) + 1) * (columns)))
+#define LAYOUT_BOTTOM_MASK(rows, columns) (LAYOUT_ALL_BITS(rows, columns) / (((Bitboard) 1 << ((rows) + 1)) - 1))
+#define LAYOUT_BOARD_MASK(rows, columns) (LAYOUT_BOTTOM_MASK(rows, columns) * (((Bitboard) 1 << (rows)) - 1))
+
+#define MAX_WINDOWS (4 * MAX_ROWS * MAX_COLS) // At most one window starts at a cell in each direction
+
+typedef struct Geometry {
+    int rows;                 // Cells per column
+    int columns;              // Number of columns
+    int connect;              // Disks in a row needed to win
+    int cells;                // rows * columns, also the longest possible game
+    int height;               // Bits per column: the cells plus a sentinel
+    int size;                 // Bits used by a whole board
+    Bitboard allBits;         // Every bit of the board, sentinels too
+    Bitboard bottomMask;      // Bottom cell of every column
+    Bitboard boardMask;       // Every cell, no sentinels
+    int (*hasConnect)(Bitboard disks);                           // Line search for `connect`
+    Bitboard (*getWinningCells)(Bitboard disks, Bitboard mask);  // Threat search for `connect`
+    int windowCount;                   // Number of winning windows, filled by setGeometry
+    Bitboard windows[MAX_WINDOWS];     // Cells of every line of `connect` cells, each listed once
+    Bitboard rowCells[1 << MAX_COLS];  // Bottom-row cells of every set of columns, filled by setGeometry
+} Geometry;
+
+extern Geometry geometry; // The board geometry of the program, set with setGeometry
+
+#define BB_HEIGHT (geometry.height)
+#define BB_SIZE (geometry.size)
+#define BB_ALL_BITS (geometry.allBits)
+#define BB_BOTTOM_MASK (geometry.bottomMask)
+#define BB_BOARD_MASK (geometry.boardMask)
+#define BB_COLUMN_MASK(col) ((((Bitboard) 1 << geometry.rows) - 1) << ((col) * geometry.height)) // Every cell of a column
+
+typedef struct BitPosition {
+    Bitboard disks[MAX_PLAYERS]; // Disks of every player, indexed from 0 ('A')
+    Bitboard mask;               // Every occupied cell
+} BitPosition;
+
+int setGeometry(int rows, int columns, int connect);
+Bitboard getCellBit(int row, int column);
+void loadBitPosition(const char board[MAX_ROWS][MAX_COLS], int rows, int columns, int players, BitPosition *pos);
+int hasConnect(Bitboard disks, int connect);
+Bitboard getCommonLineCells(Bitboard disks, int connect);
+int countWins(const BitPosition *pos, int players, int wins[MAX_PLAYERS], Bitboard common[MAX_PLAYERS]);
+Bitboard getWinningCells(Bitboard disks, Bitboard mask, int connect);
+
+#endif
@@ -0,0 +1,135 @@
+#include <string.h>
+#include "boardStats.h"
+#include "instrument.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Cells 0-7 and 1-8 of a row are compared as two 8-byte words
+_Static_assert(MAX_COLS <= 9, "rows must fit into two overlapping 8-byte comparisons");
+
+#if !defined(__SSE2__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+/**
+ * @brief Find the bytes of a word equal to a value
+ * @param word Eight cells of a row
+ * @param value The character to look for
+ * @return A mask with bit i set if byte i equals `value`
+ */
+static inline unsigned matchWord(uint64_t word, char value) {
+
+    const uint64_t LOW_BITS = 0x7F7F7F7F7F7F7F7FULL;
+    uint64_t diff = word ^ (0x0101010101010101ULL * (unsigned char) value);
+
+    // Set the top bit of every byte that is zero, then gather the top bits
+    uint64_t zero = ~(diff | ((diff & LOW_BITS) + LOW_BITS)) & ~LOW_BITS;
+
+    return (unsigned) (((zero >> 7) * 0x0102040810204080ULL) >> 56);
+}
+#endif
+
+/**
+ * @brief Find the cells of a row holding a character
+ *
+ * The row is read as cells 0-7 and cells 1-8, both within the board array
+ * whatever the row, and the two matches are merged.
+ *
+ * @param row A row of a board array
+ * @param value The character to look for
+ * @return A mask with bit i set if cell i holds `value`, for all MAX_COLS cells
+ */
+static inline unsigned matchRow(const char row[MAX_COLS], char value) {
+
+#ifdef __SSE2__
+    __m128i key = _mm_set1_epi8(value);
+    __m128i low = _mm_loadl_epi64((const __m128i *) row);
+    __m128i high = _mm_loadl_epi64((const __m128i *) (row + 1));
+
+    return (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(low, key)) |
+           (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(high, key)) << 1;
+#elif __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    uint64_t low;
+    uint64_t high;
+    memcpy(&low, row, sizeof(low));
+    memcpy(&high, row + 1, sizeof(high));
+
+    return matchWord(low, value) | matchWord(high, value) << 1;
+#else
+    unsigned cells = 0;
+    for (int col = 0; col < MAX_COLS; col++) {
+        cells |= (unsigned) (row[col] == value) << col;
+    }
+    return cells;
+#endif
+}
+
+/**
+ * @brief Gather the statistics of a board in one pass over its cells
+ *
+ * Rows are read from the top. A row's occupied cells must all be occupied
+ * in the row below too, otherwise a disk floats. Cells of players beyond
+ * `players` count as unknown, like any other character.
+ *
+ * @param board The 2D board array
+ * @param rows Number of rows in the board
+ * @param columns Number of columns in the board
+ * @param players Total number of players
+ * @param stats Filled with the statistics of the board
+ */
+void getBoardStats(const char board[MAX_ROWS][MAX_COLS], int rows, int columns, int players, BoardStats *stats) {
+
+    PROBE(PROBE_BOARD_STATS);
+    const unsigned COLUMNS = (1u << columns) - 1;
+    unsigned above = 0; // Occupied cells of the previous row
+    int known = players < MAX_PLAYERS ? players : MAX_PLAYERS;
+
+    memset(stats, 0, sizeof(BoardStats));
+
+    for (int row = 0; row < rows; row++) {
+        unsigned occupied = 0;
+        int shift = rows - 1 - row;
+
+        for (int player = 0; player < known; player++) {
+            unsigned cells = matchRow(board[row], (char) ('A' + player)) & COLUMNS;
+
+            stats->counts[player] += __builtin_popcount(cells);
+            stats->pos.disks[player] |= geometry.rowCells[cells] << shift;
+            occupied |= cells;
+        }
+
+        unsigned empty = matchRow(board[row], EMPTY_POS) & COLUMNS;
+        stats->unknown |= (occupied | empty) != COLUMNS;
+        stats->floating |= (above & ~occupied) != 0;
+        stats->pos.mask |= geometry.rowCells[occupied] << shift;
+        above = occupied;
+    }
+
+    for (int player = 0; player < known; player++) {
+        stats->disks += stats->counts[player];
+    }
+    for (int col = 0; col < columns; col++) {
+        stats->heights[col] = BB_COUNT(stats->pos.mask & BB_COLUMN_MASK(col));
+    }
+}
+
+/**
+ * @brief Read the disks of every column from the bottom up
+ *
+ * @param pos The disks of every player, stacked without gaps
+ * @param columns Number of columns in the board
+ * @param players Total number of players
+ * @param stacks Filled with the player index (0 for 'A') of every disk, bottom first
+ */
+void loadColumnStacks(const BitPosition *pos, int columns, int players, int stacks[MAX_COLS][MAX_ROWS]) {
+
+    for (int col = 0; col < columns; col++) {
+        for (int player = 0; player < players; player++) {
+            uint64_t cells = (uint64_t) ((pos->disks[player] >> (col * BB_HEIGHT)) & (((Bitboard) 1 << geometry.rows) - 1));
+
+            // Every bit of the column is the height of one of the player's disks
+            for (; cells; cells &= cells - 1) {
+                stacks[col][__builtin_ctzll(cells)] = player;
+            }
+        }
+    }
+}
@@ -0,0 +1,30 @@
+/**
+ * @file boardStats.h
+ * @brief Header file for boardStats.c
+ *
+ * Everything the validation code needs to know about a character board,
+ * gathered in one pass over its cells: the disks of every player, the
+ * height of every column and whether a disk floats or a cell holds
+ * something that is neither a disk nor empty. Every row is matched against
+ * the player characters with one SIMD (or SWAR) comparison per character,
+ * and the resulting column sets become bitboard cells through a table of
+ * the geometry, so the board is read exactly once.
+ */
+#ifndef BOARD_STATS_H
+#define BOARD_STATS_H
+
+#include "bitboard.h"
+
+typedef struct BoardStats {
+    int counts[MAX_PLAYERS];    // Disks of every player, from 'A'
+    int disks;                  // Disks on the board, every player
+    int heights[MAX_COLS];      // Disks in every column, counting any gaps
+    int floating;               // Set if a disk rests on an empty cell
+    int unknown;                // Set if a cell holds neither EMPTY_POS nor one of the players
+    BitPosition pos;            // The disks of every player as bitboards
+} BoardStats;
+
+void getBoardStats(const char board[MAX_ROWS][MAX_COLS], int rows, int columns, int players, BoardStats *stats);
+void loadColumnStacks(const BitPosition *pos, int columns, int players, int stacks[MAX_COLS][MAX_ROWS]);
+
+#endif
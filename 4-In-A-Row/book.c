@@ -0,0 +1,150 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "book.h"
+
+/**
+ * @brief Get the position key of a position's mirror image
+ *
+ * Every column takes BB_HEIGHT bits of the key, so mirroring the board
+ * only reverses the order of the column chunks.
+ *
+ * @param key A position key
+ * @return The key of the mirrored position
+ */
+PositionKey getMirrorKey(PositionKey key) {
+
+    const PositionKey COLUMN_BITS = ((PositionKey) 1 << BB_HEIGHT) - 1;
+    PositionKey mirror = 0;
+
+    for (int col = 0; col < geometry.columns; col++) {
+        PositionKey column = (key >> (col * BB_HEIGHT)) & COLUMN_BITS;
+        mirror |= column << ((geometry.columns - 1 - col) * BB_HEIGHT);
+    }
+
+    return mirror;
+}
+
+/**
+ * @brief Get the key shared by a position and its mirror image
+ * @param game The game
+ * @return The smaller of the two position keys
+ */
+PositionKey getCanonicalKey(const Game *game) {
+
+    PositionKey key = getPositionKey(game);
+    PositionKey mirror = getMirrorKey(key);
+
+    return key < mirror ? key : mirror;
+}
+
+/**
+ * @brief Map an opening book file into memory
+ *
+ * Only the header is checked; the records are used in place. A book must
+ * match the current geometry and the key width of the build.
+ *
+ * @param path Path of the book file
+ * @return The book, or NULL if the file cannot be used with this board geometry
+ */
+OpeningBook * openBook(const char *path) {
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(BookHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // The mapping stays valid without the descriptor
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    const BookHeader *header = (const BookHeader *) map;
+    const size_t RECORD_SIZE = sizeof(PositionKey) + sizeof(int8_t);
+    size_t room = ((size_t) info.st_size - sizeof(BookHeader)) / RECORD_SIZE;
+
+    // Reject books of another format or board geometry; the count is
+    // bounded by the file before it is multiplied, so it cannot overflow
+    if (memcmp(header->magic, BOOK_MAGIC, 4) != 0 || header->version != BOOK_VERSION ||
+        header->rows != geometry.rows || header->columns != geometry.columns || header->connect != geometry.connect ||
+        header->count > room || (size_t) info.st_size != sizeof(BookHeader) + header->count * RECORD_SIZE) {
+        munmap(map, (size_t) info.st_size);
+        return NULL;
+    }
+
+    OpeningBook *book = (OpeningBook *) malloc(sizeof(OpeningBook));
+    if (book == NULL) {
+        munmap(map, (size_t) info.st_size);
+        return NULL;
+    }
+
+    book->map = map;
+    book->size = (size_t) info.st_size;
+    book->depth = header->depth;
+    book->count = header->count;
+    book->keys = (const PositionKey *) ((const char *) map + sizeof(BookHeader));
+    book->scores = (const int8_t *) (book->keys + header->count);
+
+    return book;
+}
+
+/**
+ * @brief Unmap and free an opening book
+ * @param book The book, may be NULL
+ */
+void closeBook(OpeningBook *book) {
+
+    if (book == NULL) {
+        return;
+    }
+
+    munmap(book->map, book->size);
+    free(book);
+}
+
+/**
+ * @brief Look up the score of a position with a binary search
+ *
+ * @param book The book
+ * @param game The game to look up
+ * @param score The stored score for the player to move, set when found
+ * @return 1 if the position is in the book, 0 otherwise
+ */
+int lookupBook(const OpeningBook *book, const Game *game, int *score) {
+
+    if (game->moves > book->depth) {
+        return 0;
+    }
+
+    PositionKey key = getCanonicalKey(game);
+    uint64_t low = 0;
+    uint64_t high = book->count;
+
+    while (low < high) {
+        uint64_t mid = low + (high - low) / 2;
+
+        if (book->keys[mid] < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (low < book->count && book->keys[low] == key) {
+        *score = book->scores[low];
+        return 1;
+    }
+
+    return 0;
+}
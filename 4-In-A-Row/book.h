@@ -0,0 +1,45 @@
+/**
+ * @file book.h
+ * @brief Header file for book.c
+ *
+ * An opening book holds the solved score of every position up to a given
+ * number of plies. A position and its mirror image share one record, keyed
+ * by the smaller of their two position keys. The file is a fixed header
+ * followed by the sorted keys and then the scores, so it is used straight
+ * from a read-only memory mapping without any parsing.
+ */
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <stddef.h>
+#include "game.h"
+
+#define BOOK_MAGIC "C4BK"
+#define BOOK_VERSION 1
+
+typedef struct BookHeader {
+    char magic[4];      // BOOK_MAGIC
+    uint32_t version;   // BOOK_VERSION
+    int32_t rows;       // Board geometry the book was built for
+    int32_t columns;
+    int32_t connect;
+    int32_t depth;      // Deepest ply stored
+    uint64_t count;     // Number of records
+} BookHeader;
+
+typedef struct OpeningBook {
+    void *map;             // The whole mapped file
+    size_t size;           // Size of the mapping in bytes
+    int depth;             // Deepest ply stored
+    uint64_t count;        // Number of records
+    const PositionKey *keys; // Sorted canonical position keys
+    const int8_t *scores;  // Score of every key, for the player to move
+} OpeningBook;
+
+PositionKey getMirrorKey(PositionKey key);
+PositionKey getCanonicalKey(const Game *game);
+OpeningBook * openBook(const char *path);
+void closeBook(OpeningBook *book);
+int lookupBook(const OpeningBook *book, const Game *game, int *score);
+
+#endif
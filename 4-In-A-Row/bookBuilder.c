@@ -0,0 +1,325 @@
+#include <stdlib.h>
+#include <string.h>
+#include "bookBuilder.h"
+#include "util.h"
+
+/**
+ * @brief Compare two book records by key for qsort
+ * @param a Pointer to the first record
+ * @param b Pointer to the second record
+ * @return Negative, zero or positive as with strcmp
+ */
+static int compareRecords(const void *a, const void *b) {
+    return compareKeys(&((const BookRecord *) a)->key, &((const BookRecord *) b)->key);
+}
+
+/**
+ * @brief Find a key in a sorted array
+ * @param keys The sorted keys
+ * @param count Number of keys
+ * @param key The key to find
+ * @return Index of the key, or -1 if it is missing
+ */
+static long findKey(const PositionKey *keys, size_t count, PositionKey key) {
+
+    size_t low = 0;
+    size_t high = count;
+
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (keys[mid] < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return (low < count && keys[low] == key) ? (long) low : -1;
+}
+
+/**
+ * @brief Collect the canonical keys of every position one ply deeper
+ *
+ * Positions where the last move won are over and are left out.
+ *
+ * @param keys Sorted canonical keys of one ply
+ * @param count Number of keys
+ * @param nextCount Number of keys returned
+ * @return Sorted, unique keys of the next ply, NULL if memory ran out
+ */
+static PositionKey * expandLevel(const PositionKey *keys, size_t count, size_t *nextCount) {
+
+    PositionKey *next = (PositionKey *) malloc((count * geometry.columns + 1) * sizeof(PositionKey));
+    size_t size = 0;
+
+    // Check for failed allocation
+    if (next == NULL) {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        Game game;
+        loadGameFromKey(&game, keys[i]);
+
+        for (int col = 0; col < geometry.columns; col++) {
+            if (!canPlay(&game, col)) {
+                continue;
+            }
+
+            int player = getCurrentPlayer(&game);
+            gameMakeMove(&game, col);
+            if (!hasConnect(game.disks[player], geometry.connect) && game.moves < geometry.cells) {
+                next[size++] = getCanonicalKey(&game);
+            }
+            gameUnmakeMove(&game);
+        }
+    }
+
+    // Sort and drop the duplicates reached through different move orders
+    qsort(next, size, sizeof(PositionKey), compareKeys);
+    size_t unique = 0;
+    for (size_t i = 0; i < size; i++) {
+        if (unique == 0 || next[unique - 1] != next[i]) {
+            next[unique++] = next[i];
+        }
+    }
+
+    *nextCount = unique;
+    return next;
+}
+
+/**
+ * @brief Score a position from the scores of the ply below it
+ *
+ * Every child where the game goes on must be among the keys of the next ply.
+ *
+ * @param key Canonical key of the position
+ * @param childKeys Sorted keys of the next ply
+ * @param childScores Scores of the next ply
+ * @param childCount Number of positions in the next ply
+ * @return The score for the player to move
+ */
+int scoreFromChildren(PositionKey key, const PositionKey *childKeys, const int8_t *childScores,
+                      size_t childCount) {
+
+    Game game;
+    int best = MIN_SCORE;
+    loadGameFromKey(&game, key);
+
+    for (int col = 0; col < geometry.columns; col++) {
+        if (!canPlay(&game, col)) {
+            continue;
+        }
+
+        int player = getCurrentPlayer(&game);
+        int score;
+        gameMakeMove(&game, col);
+
+        if (hasConnect(game.disks[player], geometry.connect)) {
+            score = (geometry.cells + 2 - game.moves) / 2; // Won with this disk
+        } else if (game.moves == geometry.cells) {
+            score = 0;                                 // Full board
+        } else {
+            score = -childScores[findKey(childKeys, childCount, getCanonicalKey(&game))];
+        }
+        gameUnmakeMove(&game);
+
+        if (score > best) {
+            best = score;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * @brief Write the records of a book to a file
+ *
+ * @param path Path of the book file
+ * @param depth Deepest ply stored
+ * @param records The records, sorted by key
+ * @param count Number of records
+ * @return 1 on success, 0 if the file could not be written
+ */
+static int writeBook(const char *path, int depth, const BookRecord *records, size_t count) {
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        return 0;
+    }
+
+    BookHeader header;
+    memcpy(header.magic, BOOK_MAGIC, 4);
+    header.version = BOOK_VERSION;
+    header.rows = geometry.rows;
+    header.columns = geometry.columns;
+    header.connect = geometry.connect;
+    header.depth = depth;
+    header.count = count;
+
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    // All keys first, then all scores
+    for (size_t i = 0; ok && i < count; i++) {
+        ok = fwrite(&records[i].key, sizeof(PositionKey), 1, file) == 1;
+    }
+    for (size_t i = 0; ok && i < count; i++) {
+        ok = fwrite(&records[i].score, sizeof(int8_t), 1, file) == 1;
+    }
+
+    return fclose(file) == 0 && ok;
+}
+
+/**
+ * @brief Enumerate every position up to `depth` plies, one array per ply
+ *
+ * Also allocates the score array of every ply. Arrays allocated before a
+ * failure are left for the caller to free.
+ *
+ * @param levels Sorted canonical keys of every ply, filled
+ * @param scores Score arrays of every ply, allocated
+ * @param counts Number of positions of every ply, filled
+ * @param depth Deepest ply to enumerate
+ * @return 1 on success, 0 if memory ran out
+ */
+static int enumerateLevels(PositionKey *levels[], int8_t *scores[], size_t counts[], int depth) {
+
+    Game game;
+    initGame(&game);
+
+    // Start from the empty board
+    levels[0] = (PositionKey *) malloc(sizeof(PositionKey));
+    if (levels[0] == NULL) {
+        return 0;
+    }
+    levels[0][0] = getCanonicalKey(&game);
+    counts[0] = 1;
+
+    for (int d = 0; d < depth; d++) {
+        levels[d + 1] = expandLevel(levels[d], counts[d], &counts[d + 1]);
+        if (levels[d + 1] == NULL) {
+            return 0;
+        }
+        fprintf(stderr, "ply %d: %zu positions\n", d + 1, counts[d + 1]);
+    }
+
+    for (int d = 0; d <= depth; d++) {
+        scores[d] = (int8_t *) malloc(counts[d] + 1);
+        if (scores[d] == NULL) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Score every enumerated position
+ *
+ * Only the deepest ply is solved with the solver; every shallower position
+ * is scored from its children, so the book costs little more than its last
+ * ply.
+ *
+ * @param solver The solver used for the deepest ply
+ * @param levels Sorted canonical keys of every ply
+ * @param scores Score arrays of every ply, filled
+ * @param counts Number of positions of every ply
+ * @param depth Deepest ply
+ */
+static void scoreLevels(Solver *solver, PositionKey *levels[], int8_t *scores[], size_t counts[], int depth) {
+
+    // Solve the deepest ply
+    for (size_t i = 0; i < counts[depth]; i++) {
+        SolveResult result;
+        Game game;
+
+        loadGameFromKey(&game, levels[depth][i]);
+        solveGame(solver, &game, &result);
+        scores[depth][i] = (int8_t) result.score;
+
+        if ((i + 1) % 1000 == 0 || i + 1 == counts[depth]) {
+            fprintf(stderr, "solved %zu / %zu\n", i + 1, counts[depth]);
+        }
+    }
+
+    // Score every shallower ply from the one below it
+    for (int d = depth - 1; d >= 0; d--) {
+        for (size_t i = 0; i < counts[d]; i++) {
+            scores[d][i] = (int8_t) scoreFromChildren(levels[d][i], levels[d + 1], scores[d + 1], counts[d + 1]);
+        }
+    }
+}
+
+/**
+ * @brief Merge the plies into one sorted record array and write it
+ *
+ * @param path Path of the book file
+ * @param levels Sorted canonical keys of every ply
+ * @param scores Scores of every ply
+ * @param counts Number of positions of every ply
+ * @param depth Deepest ply
+ * @return 1 on success, 0 if memory ran out or the file could not be written
+ */
+static int saveLevels(const char *path, PositionKey *levels[], int8_t *scores[], size_t counts[], int depth) {
+
+    size_t total = 0;
+    for (int d = 0; d <= depth; d++) {
+        total += counts[d];
+    }
+
+    BookRecord *records = (BookRecord *) malloc(total * sizeof(BookRecord));
+    if (records == NULL) {
+        return 0;
+    }
+
+    // Plies never share a key, so the merged records are unique
+    total = 0;
+    for (int d = 0; d <= depth; d++) {
+        for (size_t i = 0; i < counts[d]; i++) {
+            records[total].key = levels[d][i];
+            records[total].score = scores[d][i];
+            total++;
+        }
+    }
+    qsort(records, total, sizeof(BookRecord), compareRecords);
+
+    int ok = writeBook(path, depth, records, total);
+    free(records);
+
+    return ok;
+}
+
+/**
+ * @brief Build an opening book of every position up to `depth` plies
+ *
+ * Positions are enumerated ply by ply, folding mirror images together, then
+ * scored and written sorted by key. Progress is reported on stderr.
+ *
+ * @param solver The solver used for the deepest ply, must not use a book
+ * @param depth Deepest ply to store
+ * @param path Path of the book file to write
+ * @return 1 on success, 0 if memory ran out or the file could not be written
+ */
+int buildBook(Solver *solver, int depth, const char *path) {
+
+    PositionKey *levels[MAX_MOVES + 1] = {NULL};
+    int8_t *scores[MAX_MOVES + 1] = {NULL};
+    size_t counts[MAX_MOVES + 1] = {0};
+
+    if (depth < 0 || depth >= geometry.cells) {
+        return 0;
+    }
+
+    int ok = enumerateLevels(levels, scores, counts, depth);
+    if (ok) {
+        scoreLevels(solver, levels, scores, counts, depth);
+        ok = saveLevels(path, levels, scores, counts, depth);
+    }
+
+    for (int d = 0; d <= depth; d++) {
+        free(levels[d]);
+        free(scores[d]);
+    }
+
+    return ok;
+}
@@ -0,0 +1,19 @@
+/**
+ * @file bookBuilder.h
+ * @brief Header file for bookBuilder.c
+ */
+#ifndef BOOK_BUILDER_H
+#define BOOK_BUILDER_H
+
+#include "solver.h"
+
+typedef struct BookRecord {
+    PositionKey key;  // Canonical position key
+    int8_t score;     // Score for the player to move
+} BookRecord;
+
+int scoreFromChildren(PositionKey key, const PositionKey *childKeys, const int8_t *childScores,
+                      size_t childCount);
+int buildBook(Solver *solver, int depth, const char *path);
+
+#endif
@@ -0,0 +1,307 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "bulkValidator.h"
+#include "solver.h"
+
+typedef struct Chunk {
+    char (*lines)[MAX_CODE_LENGTH + 3]; // Encoded boards, with room to read "\r\n" before it is stripped
+    char *verdicts;                     // '1' for a valid board, '0' otherwise
+    int count;                          // Number of lines in the chunk
+} Chunk;
+
+typedef struct ValidatorPool {
+    pthread_mutex_t lock;
+    pthread_cond_t work;      // Signalled when a new chunk is handed out
+    pthread_cond_t finished;  // Signalled when the last worker is done with a chunk
+    Chunk *chunk;             // The chunk being validated
+    atomic_int next;          // Index of the next line to take
+    int pending;              // Workers still busy with the chunk
+    unsigned generation;      // Incremented for every chunk handed out
+    int quit;                 // Set when the input is exhausted
+    int workers;              // Number of worker threads
+    int players;              // Players taking turns on the boards
+} ValidatorPool;
+
+/**
+ * @brief Check that a string is a complete `encode()` board
+ *
+ * `decode` clips what it cannot read but does not report it, so every line
+ * is checked first: it must hold exactly `rows` rows ended by '/', and the runs
+ * of every row must add up to exactly `columns` cells.
+ *
+ * @param code The encoded board
+ * @param rows Number of rows in the board
+ * @param columns Number of columns in the board
+ * @return 1 if the string is a whole board of that size, 0 otherwise
+ */
+int isWellFormedCode(const char *code, int rows, int columns) {
+
+    const char END_OF_ROW = '/';
+
+    for (int row = 0; row < rows; row++) {
+        int cells = 0;
+
+        // Read count-character pairs until the end of the row
+        while (*code != END_OF_ROW) {
+            char count = code[0];
+
+            int isBase64 = (count >= 'A' && count <= 'Z') || (count >= 'a' && count <= 'z') ||
+                           (count >= '0' && count <= '9') || count == '+' || count == '/';
+            if (!isBase64) {
+                return 0; // Also stops at the terminator, before reading past it
+            }
+
+            char cell = code[1];
+            if (cell == '\0' || cell == END_OF_ROW) {
+                return 0;
+            }
+
+            cells += get64BaseAsInteger(count);
+            if (get64BaseAsInteger(count) == 0 || cells > columns) {
+                return 0;
+            }
+            code += 2;
+        }
+
+        if (cells != columns) {
+            return 0;
+        }
+        code++; // Skip the end-of-row marker
+    }
+
+    return *code == '\0';
+}
+
+/**
+ * @brief Validate one encoded board
+ * @param code The encoded board
+ * @param players Players taking turns on the board
+ * @return '1' if the board is valid, '0' otherwise
+ */
+static char validateLine(const char *code, int players) {
+
+    char board[MAX_ROWS][MAX_COLS];
+
+    if (!isWellFormedCode(code, geometry.rows, geometry.columns)) {
+        return '0';
+    }
+
+    decode(code, board);
+    return isValidBoard(board, geometry.rows, geometry.columns, players, geometry.connect) ? '1' : '0';
+}
+
+/**
+ * @brief Validate the lines of every chunk handed out until the pool quits
+ * @param arg The pool (ValidatorPool *)
+ * @return NULL
+ */
+static void * runValidatorWorker(void *arg) {
+
+    ValidatorPool *pool = (ValidatorPool *) arg;
+    unsigned seen = 0;
+
+    while (1) {
+        // Wait for a new chunk
+        pthread_mutex_lock(&pool->lock);
+        while (pool->generation == seen && !pool->quit) {
+            pthread_cond_wait(&pool->work, &pool->lock);
+        }
+        if (pool->quit) {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        seen = pool->generation;
+        Chunk *chunk = pool->chunk;
+        pthread_mutex_unlock(&pool->lock);
+
+        // Take lines one at a time
+        int i;
+        while ((i = atomic_fetch_add(&pool->next, 1)) < chunk->count) {
+            chunk->verdicts[i] = validateLine(chunk->lines[i], pool->players);
+        }
+
+        // The last worker to finish wakes the reader
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->finished);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/**
+ * @brief Read up to CHUNK_LINES lines into a chunk
+ *
+ * A line too long to be a board is kept as an empty line, which is invalid.
+ *
+ * @param input The stream to read
+ * @param chunk The chunk to fill
+ */
+static void readChunk(FILE *input, Chunk *chunk) {
+
+    chunk->count = 0;
+
+    while (chunk->count < CHUNK_LINES) {
+        char *line = chunk->lines[chunk->count];
+
+        if (fgets(line, sizeof(*chunk->lines), input) == NULL) {
+            return;
+        }
+
+        size_t length = strlen(line);
+        if (length > 0 && line[length - 1] == '\n') {
+            line[--length] = '\0';
+        } else if (!feof(input)) {
+            // Skip the rest of an overlong line
+            int c;
+            while ((c = fgetc(input)) != '\n' && c != EOF) {
+            }
+            line[0] = '\0';
+            length = 0;
+        }
+        if (length > 0 && line[length - 1] == '\r') {
+            line[--length] = '\0';
+        }
+
+        chunk->count++;
+    }
+}
+
+/**
+ * @brief Allocate the buffers of a chunk
+ * @param chunk The chunk
+ * @return 1 on success, 0 if memory ran out
+ */
+static int makeChunk(Chunk *chunk) {
+    chunk->lines = malloc(CHUNK_LINES * sizeof(*chunk->lines));
+    chunk->verdicts = (char *) malloc(CHUNK_LINES);
+    chunk->count = 0;
+    return chunk->lines != NULL && chunk->verdicts != NULL;
+}
+
+/**
+ * @brief Free the buffers of a chunk
+ * @param chunk The chunk
+ */
+static void freeChunk(Chunk *chunk) {
+    free(chunk->lines);
+    free(chunk->verdicts);
+}
+
+/**
+ * @brief Write the verdicts of a chunk, one per line
+ * @param output The stream to write
+ * @param chunk The validated chunk
+ * @param stats Counters to update
+ */
+static void writeVerdicts(FILE *output, const Chunk *chunk, BulkStats *stats) {
+
+    for (int i = 0; i < chunk->count; i++) {
+        putc(chunk->verdicts[i], output);
+        putc('\n', output);
+        stats->valid += chunk->verdicts[i] == '1';
+    }
+    stats->boards += chunk->count;
+}
+
+/**
+ * @brief Validate every encoded board of a stream
+ *
+ * Writes '1' or '0' per input line, in input order. The next chunk is read
+ * while the worker threads validate the current one.
+ *
+ * @param input Stream with one encoded board per line
+ * @param output Stream for the verdicts
+ * @param players Players taking turns on the boards, 2 to MAX_PLAYERS
+ * @param threads Number of worker threads
+ * @param stats Number of boards, valid boards and time
+ * @return 1 on success, 0 if memory or threads ran out
+ */
+int validateStream(FILE *input, FILE *output, int players, int threads, BulkStats *stats) {
+
+    Chunk chunks[2];
+    pthread_t workers[MAX_THREADS];
+    ValidatorPool pool;
+    double start = getTime();
+
+    stats->boards = 0;
+    stats->valid = 0;
+
+    if (threads < 1) {
+        threads = 1;
+    } else if (threads > MAX_THREADS) {
+        threads = MAX_THREADS;
+    }
+
+    int ok = makeChunk(&chunks[0]);
+    ok = makeChunk(&chunks[1]) && ok;
+    if (!ok) {
+        freeChunk(&chunks[0]);
+        freeChunk(&chunks[1]);
+        return 0;
+    }
+
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.work, NULL);
+    pthread_cond_init(&pool.finished, NULL);
+    atomic_init(&pool.next, 0);
+    pool.chunk = NULL;
+    pool.pending = 0;
+    pool.generation = 0;
+    pool.quit = 0;
+    pool.workers = 0;
+    pool.players = players;
+
+    for (; pool.workers < threads; pool.workers++) {
+        if (pthread_create(&workers[pool.workers], NULL, runValidatorWorker, &pool) != 0) {
+            break;
+        }
+    }
+
+    int current = 0;
+    readChunk(input, &chunks[current]);
+
+    while (pool.workers > 0 && chunks[current].count > 0) {
+        // Hand the chunk to the workers
+        pthread_mutex_lock(&pool.lock);
+        pool.chunk = &chunks[current];
+        atomic_store(&pool.next, 0);
+        pool.pending = pool.workers;
+        pool.generation++;
+        pthread_cond_broadcast(&pool.work);
+        pthread_mutex_unlock(&pool.lock);
+
+        // Read ahead while they work
+        readChunk(input, &chunks[!current]);
+
+        pthread_mutex_lock(&pool.lock);
+        while (pool.pending > 0) {
+            pthread_cond_wait(&pool.finished, &pool.lock);
+        }
+        pthread_mutex_unlock(&pool.lock);
+
+        writeVerdicts(output, &chunks[current], stats);
+        current = !current;
+    }
+
+    // Stop the workers
+    pthread_mutex_lock(&pool.lock);
+    pool.quit = 1;
+    pthread_cond_broadcast(&pool.work);
+    pthread_mutex_unlock(&pool.lock);
+    for (int i = 0; i < pool.workers; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    ok = pool.workers > 0;
+    pthread_mutex_destroy(&pool.lock);
+    pthread_cond_destroy(&pool.work);
+    pthread_cond_destroy(&pool.finished);
+    freeChunk(&chunks[0]);
+    freeChunk(&chunks[1]);
+
+    stats->seconds = getTime() - start;
+    return ok;
+}
@@ -0,0 +1,27 @@
+/**
+ * @file bulkValidator.h
+ * @brief Header file for bulkValidator.c
+ *
+ * Validates a stream of boards in the `encode()` format, one per line, on a
+ * pool of threads. Lines are read in fixed-size chunks: while the threads
+ * validate one chunk the next one is read, so memory stays bounded by two
+ * chunks whatever the size of the input. Verdicts are written in input order.
+ */
+#ifndef BULK_VALIDATOR_H
+#define BULK_VALIDATOR_H
+
+#include "4inARow.h"
+
+#define CHUNK_LINES 8192                         // Lines validated per chunk
+#define MAX_CODE_LENGTH (2 * MAX_ROWS * MAX_COLS + MAX_ROWS) // Longest encoded board, without the terminator
+
+typedef struct BulkStats {
+    unsigned long long boards;  // Lines read
+    unsigned long long valid;   // Lines holding a valid board
+    double seconds;             // Wall-clock time
+} BulkStats;
+
+int isWellFormedCode(const char *code, int rows, int columns);
+int validateStream(FILE *input, FILE *output, int players, int threads, BulkStats *stats);
+
+#endif
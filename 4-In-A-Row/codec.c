@@ -0,0 +1,385 @@
+#include <stdlib.h>
+#include <string.h>
+#include "codec.h"
+#include "bitboard.h"
+#include "solver.h"
+#include "instrument.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// A row and its copy shifted by one cell are compared in 8-byte words
+_Static_assert(MAX_COLS <= 9, "rows must fit into one 8-byte comparison");
+
+const char base64Digits[65] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Value of every base64 digit; like the original decoder, any other character reads as 63
+const unsigned char base64Values[256] = {
+    63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63,
+    63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63,
+    63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 62, 63, 63, 63, 63,
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 63, 63, 63, 63, 63, 63,
+    63,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 63, 63, 63, 63, 63,
+    63, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 63, 63, 63, 63, 63,
+    63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63,
+    63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63,
+    63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63,
+    63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63,
+    63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63,
+    63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63,
+    63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63,
+    63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63,
+};
+
+/**
+ * @brief Find the cells of a row that differ from their right neighbour
+ *
+ * Cells 0-7 are compared with cells 1-8 in a single operation, so every
+ * run of the row ends at a set bit.
+ *
+ * @param row A row of a board array
+ * @return A mask with bit i set if cell i differs from cell i + 1
+ */
+static inline unsigned getRunEnds(const char row[MAX_COLS]) {
+
+#ifdef __SSE2__
+    __m128i cells = _mm_loadl_epi64((const __m128i *) row);
+    __m128i next = _mm_loadl_epi64((const __m128i *) (row + 1));
+
+    return ~_mm_movemask_epi8(_mm_cmpeq_epi8(cells, next)) & 0xFF;
+#elif __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    uint64_t cells;
+    uint64_t next;
+    memcpy(&cells, row, sizeof(cells));
+    memcpy(&next, row + 1, sizeof(next));
+
+    // Set the top bit of every byte that differs, then gather the top bits
+    const uint64_t LOW_BITS = 0x7F7F7F7F7F7F7F7FULL;
+    uint64_t diff = cells ^ next;
+    uint64_t high = (diff | ((diff & LOW_BITS) + LOW_BITS)) & ~LOW_BITS;
+
+    return (unsigned) (((high >> 7) * 0x0102040810204080ULL) >> 56);
+#else
+    unsigned ends = 0;
+    for (int col = 0; col < MAX_COLS - 1; col++) {
+        ends |= (unsigned) (row[col] != row[col + 1]) << col;
+    }
+    return ends;
+#endif
+}
+
+/**
+ * @brief Encode a 2D board into the `encode()` format
+ *
+ * @param board The 2D board array to encode
+ * @param rows Number of rows in the board
+ * @param columns Number of columns in the board
+ * @param code Buffer of at least 2 * rows * columns + rows + 1 characters
+ * @return Length of the encoded string
+ */
+int encodeBoard(const char board[MAX_ROWS][MAX_COLS], int rows, int columns, char *code) {
+
+    PROBE(PROBE_ENCODE);
+    const unsigned LAST_CELL = 1u << (columns - 1);
+    char *start = code;
+
+    for (int row = 0; row < rows; row++) {
+        // Every run ends where a cell differs from the next one, or at the last cell
+        unsigned ends = (getRunEnds(board[row]) & (LAST_CELL - 1)) | LAST_CELL;
+        int first = 0;
+
+        while (ends) {
+            int end = __builtin_ctz(ends);
+
+            *code++ = base64Digits[end - first + 1];
+            *code++ = board[row][end];
+            first = end + 1;
+            ends &= ends - 1;
+        }
+        *code++ = '/';
+    }
+
+    *code = '\0';
+    return (int) (code - start);
+}
+
+/**
+ * @brief Decode an `encode()` string into a 2D board array
+ *
+ * Every row is filled in a local buffer and copied to the board when its
+ * '/' is read. Any string is safe to decode: decoding stops at the
+ * terminator or after `geometry.rows` rows, a last row without its '/' is
+ * still copied, and runs are clipped to `geometry.columns`. Whether the
+ * string was a complete board is for `isWellFormedCode` to say.
+ *
+ * @param code The encoded board
+ * @param board The 2D board array to fill
+ */
+void decodeBoard(const char *code, char board[MAX_ROWS][MAX_COLS]) {
+
+    PROBE(PROBE_DECODE);
+    const uint64_t EVERY_BYTE = 0x0101010101010101ULL;
+    const int ROWS = geometry.rows;
+    const int COLUMNS = geometry.columns;
+    char cells[MAX_COLS + 8]; // Row being decoded, with room for a whole word past its end
+    int row = 0;
+    int col = 0;
+
+    while (*code != '\0' && row < ROWS) {
+        if (*code == '/') {
+            memcpy(board[row], cells, col);
+            row++;
+            col = 0;
+            code++;
+            continue;
+        }
+        if (code[1] == '\0') {
+            break; // A count without its cell
+        }
+
+        int count = base64Values[(unsigned char) code[0]];
+        uint64_t fill = (unsigned char) code[1] * EVERY_BYTE;
+
+        // Write a whole word of the cell and one more byte; only `count` of them are kept
+        if (col < COLUMNS) {
+            memcpy(&cells[col], &fill, sizeof(fill));
+            cells[col + 8] = code[1];
+            col += count ? count : 1; // A zero count still takes a column, as in `decode`
+            col = col < COLUMNS ? col : COLUMNS;
+        }
+        code += 2;
+    }
+
+    // The last row may be missing its '/'
+    if (row < ROWS && col > 0) {
+        memcpy(board[row], cells, col);
+    }
+}
+
+/**
+ * @brief Encode an array of boards
+ *
+ * @param boards The boards
+ * @param count Number of boards
+ * @param rows Number of rows in every board
+ * @param columns Number of columns in every board
+ * @param codes One string buffer per board
+ * @return Total length of the encoded strings
+ */
+size_t encodeBoards(const char boards[][MAX_ROWS][MAX_COLS], size_t count, int rows, int columns,
+                    char codes[][CODE_SIZE]) {
+
+    size_t length = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        length += encodeBoard(boards[i], rows, columns, codes[i]);
+    }
+
+    return length;
+}
+
+/**
+ * @brief Decode an array of encoded boards
+ *
+ * @param codes The encoded boards
+ * @param count Number of boards
+ * @param boards The boards to fill
+ */
+void decodeBoards(const char codes[][CODE_SIZE], size_t count, char boards[][MAX_ROWS][MAX_COLS]) {
+
+    for (size_t i = 0; i < count; i++) {
+        decodeBoard(codes[i], boards[i]);
+    }
+}
+
+/*
+ * The original character-by-character codec, kept unchanged to check and
+ * time the table-driven one against.
+ */
+
+static char referenceDigit(int input) {
+
+    if (input >= 0 && input <= 25) {
+        return 'A' + input;
+    }
+    if (input >= 26 && input <= 51) {
+        return 'a' + (input - 26);
+    }
+    if (input >= 52 && input <= 61) {
+        return '0' + (input - 52);
+    }
+    return input == 62 ? '+' : '/';
+}
+
+static int referenceValue(char input) {
+
+    if (input >= 'A' && input <= 'Z') {
+        return input - 'A';
+    } else if (input >= 'a' && input <= 'z') {
+        return input - ('a' - 26);
+    } else if (input >= '0' && input <= '9') {
+        return input - ('0' - 52);
+    } else if (input == '+') {
+        return 62;
+    }
+    return 63;
+}
+
+static char * referenceInsert(char *code, char numOfOccurrences, char theChar) {
+    *code++ = referenceDigit(numOfOccurrences);
+    *code++ = theChar;
+    return code;
+}
+
+static void referenceEncode(const char board[MAX_ROWS][MAX_COLS], int rows, int columns, char *code) {
+
+    const int RIGHT_BOUNDARY = columns - 2;
+    int counter = 1;
+
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < columns; col++) {
+            if (col < RIGHT_BOUNDARY) {
+                if (board[row][col] == board[row][col + 1]) {
+                    counter++;
+                } else {
+                    code = referenceInsert(code, counter, board[row][col]);
+                    counter = 1;
+                }
+            } else {
+                if (board[row][col] == board[row][col + 1]) {
+                    counter++;
+                    code = referenceInsert(code, counter, board[row][col]);
+                } else {
+                    code = referenceInsert(code, counter, board[row][col]);
+                    code = referenceInsert(code, 1, board[row][col + 1]);
+                }
+                counter = 1;
+                break;
+            }
+        }
+        *code++ = '/';
+    }
+    *code = '\0';
+}
+
+static void referenceDecode(const char *code, char board[MAX_ROWS][MAX_COLS]) {
+
+    int row = 0;
+    int col = 0;
+
+    while (*code != '\0') {
+        int cols = referenceValue(*code);
+        code++;
+        char currChar = *code;
+        code++;
+
+        for (int i = col; cols > 0; cols--) {
+            col = i;
+            board[row][i++] = currChar;
+        }
+        col++;
+
+        if (*code == '/') {
+            row++;
+            col = 0;
+            code++;
+        }
+    }
+}
+
+/**
+ * @brief Time both codecs on the same random boards and compare their output
+ *
+ * The boards have random column heights and random owners, in the current
+ * geometry. Encoded strings must match byte for byte and decoded boards
+ * cell for cell.
+ *
+ * @param count Number of boards
+ * @param rounds Times every board is converted by each codec
+ * @param stats The timings and the verdict
+ * @return 1 on success, 0 if memory ran out
+ */
+int benchmarkCodec(size_t count, int rounds, CodecStats *stats) {
+
+    char (*boards)[MAX_ROWS][MAX_COLS] = malloc(count * sizeof(*boards));
+    char (*decoded)[MAX_ROWS][MAX_COLS] = malloc(count * sizeof(*decoded));
+    char (*references)[CODE_SIZE] = malloc(count * sizeof(*references));
+    char (*codes)[CODE_SIZE] = malloc(count * sizeof(*codes));
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+
+    if (boards == NULL || decoded == NULL || references == NULL || codes == NULL) {
+        free(boards);
+        free(decoded);
+        free(references);
+        free(codes);
+        return 0;
+    }
+
+    // Stack random disks in every column
+    for (size_t i = 0; i < count; i++) {
+        initBoard(boards[i], geometry.rows, geometry.columns);
+
+        for (int col = 0; col < geometry.columns; col++) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            int height = (int) (state % (geometry.rows + 1));
+
+            for (int k = 0; k < height; k++) {
+                boards[i][geometry.rows - 1 - k][col] = (state >> (16 + k)) & 1 ? 'A' : 'B';
+            }
+        }
+    }
+
+    stats->boards = count;
+    stats->rounds = rounds;
+
+    double start = getTime();
+    for (int round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < count; i++) {
+            referenceEncode(boards[i], geometry.rows, geometry.columns, references[i]);
+        }
+    }
+    stats->referenceEncode = getTime() - start;
+
+    start = getTime();
+    for (int round = 0; round < rounds; round++) {
+        encodeBoards((const char (*)[MAX_ROWS][MAX_COLS]) boards, count, geometry.rows, geometry.columns, codes);
+    }
+    stats->tableEncode = getTime() - start;
+
+    stats->identical = 1;
+    for (size_t i = 0; i < count; i++) {
+        stats->identical &= strcmp(references[i], codes[i]) == 0;
+    }
+
+    start = getTime();
+    for (int round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < count; i++) {
+            referenceDecode(references[i], decoded[i]);
+        }
+    }
+    stats->referenceDecode = getTime() - start;
+
+    start = getTime();
+    for (int round = 0; round < rounds; round++) {
+        decodeBoards((const char (*)[CODE_SIZE]) codes, count, boards);
+    }
+    stats->tableDecode = getTime() - start;
+
+    // Both decoders must rebuild the cells of the board
+    for (size_t i = 0; i < count; i++) {
+        for (int row = 0; row < geometry.rows; row++) {
+            stats->identical &= memcmp(boards[i][row], decoded[i][row], geometry.columns) == 0;
+        }
+    }
+
+    free(boards);
+    free(decoded);
+    free(references);
+    free(codes);
+    return 1;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file codec.h
+ * @brief Header file for codec.c
+ *
+ * Table-driven implementation of the `encode()` base64 run-length format.
+ * Base64 digits are converted with lookup tables instead of range checks,
+ * and the runs of a row are found all at once by comparing every cell with
+ * its right neighbour in one SIMD (or SWAR) operation. The output is the
+ * same string, byte for byte, as the original character-by-character code,
+ * which is kept as a reference for the benchmark.
+ */
+#ifndef CODEC_H
+#define CODEC_H
+
+#include <stddef.h>
+#include "4inARow.h"
+
+#define CODE_SIZE (2 * MAX_ROWS * MAX_COLS + MAX_ROWS + 1) // Buffer for the longest encoded board and its terminator
+
+typedef struct CodecStats {
+    size_t boards;           // Boards converted per round
+    int rounds;              // Times every board was converted
+    double referenceEncode;  // Seconds spent by the original encoder
+    double tableEncode;      // Seconds spent by the table-driven encoder
+    double referenceDecode;  // Seconds spent by the original decoder
+    double tableDecode;      // Seconds spent by the table-driven decoder
+    int identical;           // 1 if both codecs agreed on every board
+} CodecStats;
+
+extern const char base64Digits[65];
+extern const unsigned char base64Values[256];
+
+int encodeBoard(const char board[MAX_ROWS][MAX_COLS], int rows, int columns, char *code);
+void decodeBoard(const char *code, char board[MAX_ROWS][MAX_COLS]);
+size_t encodeBoards(const char boards[][MAX_ROWS][MAX_COLS], size_t count, int rows, int columns,
+                    char codes[][CODE_SIZE]);
+void decodeBoards(const char codes[][CODE_SIZE], size_t count, char boards[][MAX_ROWS][MAX_COLS]);
+int benchmarkCodec(size_t count, int rounds, CodecStats *stats);
+
+#endif
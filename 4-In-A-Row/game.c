@@ -0,0 +1,410 @@
+#include <pthread.h>
+#include "game.h"
+#include "boardStats.h"
+#include "bulkValidator.h"
+
+static uint64_t zobristTable[NUM_PLAYERS][BITBOARD_BITS]; // Random key of every disk on every bitboard cell
+static pthread_once_t zobristOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Fill the Zobrist table with fixed pseudo-random numbers
+ *
+ * The numbers come from a splitmix64 sequence with a constant seed, so
+ * hashes are the same in every run and can be stored on disk. The table
+ * covers every bit of a Bitboard, so it does not depend on the geometry.
+ */
+static void initZobrist(void) {
+
+    uint64_t state = 0x4A0B5C3D2E1F6071ULL;
+
+    for (int player = 0; player < NUM_PLAYERS; player++) {
+        for (int bit = 0; bit < BITBOARD_BITS; bit++) {
+            // splitmix64 step
+            uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            zobristTable[player][bit] = z ^ (z >> 31);
+        }
+    }
+}
+
+/**
+ * @brief Get the Zobrist key of a player's disk on a bitboard cell
+ *
+ * @param player The player index, 0 for 'A'
+ * @param bit Bit index of the cell
+ * @return The key to XOR into the hash
+ */
+uint64_t getZobrist(int player, int bit) {
+    return zobristTable[player][bit];
+}
+
+/**
+ * @brief Compute the Zobrist hash of a game from scratch
+ *
+ * @param game The game, its bitboards must be filled
+ * @return The hash of every disk on the board
+ */
+static uint64_t computeHash(const Game *game) {
+
+    uint64_t hash = 0;
+
+    for (int player = 0; player < NUM_PLAYERS; player++) {
+        Bitboard disks = game->disks[player];
+
+        // XOR in the key of every disk
+        while (disks) {
+            hash ^= zobristTable[player][BB_FIRST(disks)];
+            disks &= disks - 1;
+        }
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Initialize an empty game
+ *
+ * @param game The game to initialize
+ */
+void initGame(Game *game) {
+
+    pthread_once(&zobristOnce, initZobrist);
+
+    for (int i = 0; i < NUM_PLAYERS; i++) {
+        game->disks[i] = 0;
+    }
+    for (int col = 0; col < MAX_COLS; col++) {
+        game->heights[col] = 0;
+    }
+    game->mask = 0;
+    game->moves = 0;
+    game->firstUndoable = 0;
+    game->hash = 0;
+}
+
+/**
+ * @brief Load a game from a character board
+ *
+ * The order in which the disks were played is unknown, so moves loaded
+ * this way cannot be undone; only moves made afterwards can.
+ *
+ * @param game The game to fill
+ * @param board The 2D board array to load
+ * @param rows Number of rows in the board
+ * @param columns Number of columns in the board
+ * @return VALID_BOARD on success, INVALID_BOARD if a column has a floating disk or a cell
+ *         holds neither a disk nor EMPTY_POS
+ */
+int loadGame(Game *game, const char board[MAX_ROWS][MAX_COLS], int rows, int columns) {
+
+    BoardStats stats;
+    getBoardStats(board, rows, columns, NUM_PLAYERS, &stats);
+    initGame(game);
+
+    // The disks of a column must be stacked from its bottom without gaps, and
+    // any other character would silently read as an empty cell
+    if (stats.floating || stats.unknown) {
+        return INVALID_BOARD;
+    }
+
+    for (int i = 0; i < NUM_PLAYERS; i++) {
+        game->disks[i] = stats.pos.disks[i];
+    }
+    game->mask = stats.pos.mask;
+    for (int col = 0; col < columns; col++) {
+        game->heights[col] = stats.heights[col];
+    }
+    game->moves = stats.disks;
+    game->firstUndoable = game->moves;
+    game->hash = computeHash(game);
+
+    return VALID_BOARD;
+}
+
+/**
+ * @brief Write a game back into a character board
+ *
+ * @param game The game to store
+ * @param board The 2D board array to fill
+ */
+void storeGame(const Game *game, char board[MAX_ROWS][MAX_COLS]) {
+
+    for (int row = 0; row < geometry.rows; row++) {
+        for (int col = 0; col < geometry.columns; col++) {
+            Bitboard bit = getCellBit(row, col);
+            board[row][col] = EMPTY_POS;
+
+            // Find the owner of the cell, if any
+            for (int i = 0; i < NUM_PLAYERS; i++) {
+                if (game->disks[i] & bit) {
+                    board[row][col] = 'A' + i;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Check if a column can take another disk
+ *
+ * @param game The game
+ * @param column Column index to check
+ * @return 1 if the column exists and is not full, 0 otherwise
+ */
+int canPlay(const Game *game, int column) {
+    return column >= 0 && column < geometry.columns && game->heights[column] < geometry.rows;
+}
+
+/**
+ * @brief Get the player whose turn it is
+ *
+ * @param game The game
+ * @return The player index, 0 for 'A'
+ */
+int getCurrentPlayer(const Game *game) {
+    return game->moves % NUM_PLAYERS;
+}
+
+/**
+ * @brief Drop the current player's disk into a column
+ *
+ * The move is not checked; the caller must make sure `canPlay` holds.
+ *
+ * @param game The game
+ * @param column Column index to play
+ */
+void gameMakeMove(Game *game, int column) {
+
+    int index = column * BB_HEIGHT + game->heights[column];
+    Bitboard bit = (Bitboard) 1 << index;
+    int player = game->moves % NUM_PLAYERS;
+
+    game->disks[player] |= bit;
+    game->mask |= bit;
+    game->hash ^= zobristTable[player][index];
+    game->heights[column]++;
+    game->history[game->moves++] = column;
+}
+
+/**
+ * @brief Take back the last move
+ *
+ * The caller must make sure there is a move to take back.
+ *
+ * @param game The game
+ */
+void gameUnmakeMove(Game *game) {
+
+    int column = game->history[--game->moves];
+    int index = column * BB_HEIGHT + --game->heights[column];
+    Bitboard bit = (Bitboard) 1 << index;
+    int player = game->moves % NUM_PLAYERS;
+
+    game->disks[player] &= ~bit;
+    game->mask &= ~bit;
+    game->hash ^= zobristTable[player][index];
+}
+
+/**
+ * @brief Take back up to `count` of the last moves
+ *
+ * Moves that were loaded with `loadGame` are never taken back.
+ *
+ * @param game The game
+ * @param count Number of moves to take back
+ * @return Number of moves actually taken back
+ */
+int gameUndoMoves(Game *game, int count) {
+
+    int undoable = game->moves - game->firstUndoable;
+    if (count > undoable) {
+        count = undoable;
+    }
+
+    for (int i = 0; i < count; i++) {
+        gameUnmakeMove(game);
+    }
+
+    return count < 0 ? 0 : count;
+}
+
+/**
+ * @brief Play a checked move and report the game outcome it produced
+ *
+ * Only the disks of the player who moved can form a new line, so a single
+ * bitboard is checked.
+ *
+ * @param game The game
+ * @param column Column index to play
+ * @return GAME_WON, GAME_TIE or GAME_ON after the move, MOVE_FAILED if the column is not playable
+ */
+int gamePlay(Game *game, int column) {
+
+    if (!canPlay(game, column)) {
+        return MOVE_FAILED;
+    }
+
+    int player = getCurrentPlayer(game);
+    gameMakeMove(game, column);
+
+    if (hasConnect(game->disks[player], geometry.connect)) {
+        return GAME_WON;
+    }
+    if (game->moves == geometry.cells) {
+        return GAME_TIE;
+    }
+
+    return GAME_ON;
+}
+
+/**
+ * @brief Get the position key of a two-player game
+ *
+ * Adding the bottom mask to the occupied cells sets the bit right above
+ * every column's top disk; adding player A's disks below it keeps the owner
+ * of every disk. The result fits in BB_SIZE bits and is unique per position.
+ *
+ * @param game The game
+ * @return The position key
+ */
+PositionKey getPositionKey(const Game *game) {
+    return game->disks[0] + game->mask + BB_BOTTOM_MASK;
+}
+
+/**
+ * @brief Rebuild a two-player game from its position key
+ *
+ * @param game The game to fill
+ * @param key A key made by `getPositionKey`
+ * @return VALID_BOARD on success, INVALID_BOARD if the key is malformed
+ */
+int loadGameFromKey(Game *game, PositionKey key) {
+
+    const Bitboard COLUMN_BITS = ((Bitboard) 1 << BB_HEIGHT) - 1;
+
+    if (NUM_PLAYERS != 2 || (key & ~BB_ALL_BITS)) {
+        return INVALID_BOARD;
+    }
+
+    initGame(game);
+
+    for (int col = 0; col < geometry.columns; col++) {
+        uint64_t column = (uint64_t) ((key >> (col * BB_HEIGHT)) & COLUMN_BITS);
+
+        // Every column has a marker bit right above its top disk
+        if (column == 0) {
+            return INVALID_BOARD;
+        }
+
+        int height = 63 - __builtin_clzll(column);
+        Bitboard cells = (((Bitboard) 1 << height) - 1) << (col * BB_HEIGHT);
+
+        game->disks[0] |= key & cells;
+        game->mask |= cells;
+        game->heights[col] = height;
+        game->moves += height;
+    }
+
+    game->disks[1] = game->mask ^ game->disks[0];
+    game->firstUndoable = game->moves;
+    game->hash = computeHash(game);
+
+    return VALID_BOARD;
+}
+
+/**
+ * @brief Convert an `encode()` string to a position key
+ *
+ * @param code The encoded board
+ * @param key The position key
+ * @return VALID_BOARD on success, INVALID_BOARD if the string is not a board or the board
+ *         has a floating disk
+ */
+int codeToKey(const char *code, PositionKey *key) {
+
+    char board[MAX_ROWS][MAX_COLS];
+    Game game;
+
+    if (!isWellFormedCode(code, geometry.rows, geometry.columns)) {
+        return INVALID_BOARD;
+    }
+
+    initBoard(board, geometry.rows, geometry.columns);
+    decode(code, board);
+
+    if (!loadGame(&game, board, geometry.rows, geometry.columns)) {
+        return INVALID_BOARD;
+    }
+
+    *key = getPositionKey(&game);
+    return VALID_BOARD;
+}
+
+/**
+ * @brief Convert a position key to an `encode()` string
+ *
+ * @param key The position key
+ * @param code Buffer of at least 2 * rows * columns + rows + 1 characters
+ * @return VALID_BOARD on success, INVALID_BOARD if the key is malformed
+ */
+int keyToCode(PositionKey key, char *code) {
+
+    char board[MAX_ROWS][MAX_COLS];
+    Game game;
+
+    if (!loadGameFromKey(&game, key)) {
+        return INVALID_BOARD;
+    }
+
+    storeGame(&game, board);
+    encode(board, geometry.rows, geometry.columns, code);
+    return VALID_BOARD;
+}
+
+/**
+ * @brief Write a position key as hexadecimal digits
+ *
+ * @param key The position key
+ * @param text Buffer of at least KEY_TEXT_LENGTH characters
+ */
+void formatKey(PositionKey key, char *text) {
+
+#ifdef WIDE_BITBOARD
+    uint64_t high = (uint64_t) (key >> 64);
+    if (high) {
+        sprintf(text, "%llx%016llx", (unsigned long long) high, (unsigned long long) (uint64_t) key);
+        return;
+    }
+#endif
+
+    sprintf(text, "%016llx", (unsigned long long) key);
+}
+
+/**
+ * @brief Read a position key from hexadecimal digits
+ *
+ * @param text The digits, without a prefix
+ * @param key The position key
+ * @return VALID_BOARD on success, INVALID_BOARD if the text is not a key
+ */
+int parseKey(const char *text, PositionKey *key) {
+
+    const int MAX_DIGITS = BITBOARD_BITS / 4;
+    int digits = 0;
+
+    *key = 0;
+    for (; *text != '\0'; text++, digits++) {
+        char c = *text;
+        int value = c >= '0' && c <= '9' ? c - '0' :
+                    c >= 'a' && c <= 'f' ? c - 'a' + 10 :
+                    c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+
+        if (value < 0 || digits == MAX_DIGITS) {
+            return INVALID_BOARD;
+        }
+        *key = (*key << 4) | (PositionKey) value;
+    }
+
+    return digits > 0 ? VALID_BOARD : INVALID_BOARD;
+}
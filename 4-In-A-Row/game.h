@@ -0,0 +1,53 @@
+/**
+ * @file game.h
+ * @brief Header file for game.c
+ *
+ * A Game keeps the bitboards of a position together with the height of
+ * every column and the stack of played columns, so making and taking back
+ * a move never has to look at the board.
+ */
+#ifndef GAME_H
+#define GAME_H
+
+#include "bitboard.h"
+
+#define MAX_MOVES (MAX_ROWS * MAX_COLS) // Longest game any geometry can have
+
+typedef Bitboard PositionKey;          // Unique key of a two-player position, see getPositionKey
+#define KEY_TEXT_LENGTH (BITBOARD_BITS / 4 + 1) // Hexadecimal digits of a key plus the terminator
+
+// A key folded to 64 bits; exact unless the bitboards are wider
+#ifdef WIDE_BITBOARD
+#define FOLD_KEY(key) ((uint64_t) (key) ^ (uint64_t) ((key) >> 64))
+#else
+#define FOLD_KEY(key) (key)
+#endif
+
+typedef struct Game {
+    Bitboard disks[NUM_PLAYERS]; // Disks of every player, indexed from 0 ('A')
+    Bitboard mask;               // Every occupied cell
+    int heights[MAX_COLS];       // Number of disks in each column
+    int history[MAX_MOVES];      // Column of every move, indexed by ply
+    int moves;                   // Number of disks on the board
+    int firstUndoable;           // Plies before this one were loaded, not played
+    uint64_t hash;               // Zobrist hash of the disks on the board
+} Game;
+
+void initGame(Game *game);
+int loadGame(Game *game, const char board[MAX_ROWS][MAX_COLS], int rows, int columns);
+void storeGame(const Game *game, char board[MAX_ROWS][MAX_COLS]);
+int canPlay(const Game *game, int column);
+int getCurrentPlayer(const Game *game);
+void gameMakeMove(Game *game, int column);
+void gameUnmakeMove(Game *game);
+int gameUndoMoves(Game *game, int count);
+int gamePlay(Game *game, int column);
+uint64_t getZobrist(int player, int bit);
+PositionKey getPositionKey(const Game *game);
+int loadGameFromKey(Game *game, PositionKey key);
+int codeToKey(const char *code, PositionKey *key);
+int keyToCode(PositionKey key, char *code);
+void formatKey(PositionKey key, char *text);
+int parseKey(const char *text, PositionKey *key);
+
+#endif
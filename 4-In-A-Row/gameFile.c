@@ -0,0 +1,381 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "gameFile.h"
+#include "solver.h"
+
+typedef struct ReplayPool {
+    const GameFile *file;
+    int method;              // REPLAY_GAME or REPLAY_BOARD
+    ReplayVisitor visitor;   // Called for every game, may be NULL
+    void *context;
+    atomic_int next;         // Index of the next batch to replay
+} ReplayPool;
+
+typedef struct ReplayWorker {
+    ReplayPool *pool;
+    ReplayStats stats;       // Counts of this thread only
+} ReplayWorker;
+
+/**
+ * @brief Fill a header for the current geometry
+ * @param header The header
+ */
+static void initGameFileHeader(GameFileHeader *header) {
+    memcpy(header->magic, GAME_FILE_MAGIC, 4);
+    header->version = GAME_FILE_VERSION;
+    header->rows = geometry.rows;
+    header->columns = geometry.columns;
+    header->connect = geometry.connect;
+    header->players = NUM_PLAYERS;
+}
+
+/**
+ * @brief Cut a game left unfinished by a crashed writer off the end of a file
+ *
+ * Games are framed by their ply count only, so anything appended after a
+ * partial game would be read from the wrong offset.
+ *
+ * @param file The game file, opened for appending
+ * @param path Path of the game file
+ * @return 1 if the file now ends with a complete game, 0 if it is corrupt or cannot be cut
+ */
+static int dropPartialGame(FILE *file, const char *path) {
+
+    GameFile *games = openGameFile(path);
+    int ok = games != NULL;
+
+    if (ok && games->truncated) {
+        ok = ftruncate(fileno(file), (off_t) (sizeof(GameFileHeader) + games->length)) == 0;
+    }
+
+    closeGameFile(games);
+    return ok;
+}
+
+/**
+ * @brief Open a game file for appending, creating it if needed
+ *
+ * A new file gets a header; an existing one must have been written for the
+ * current geometry, and a partial game at its end is cut off first.
+ *
+ * @param path Path of the game file
+ * @return The file, or NULL if it cannot be written, is corrupt or is for another geometry
+ */
+FILE * openGameWriter(const char *path) {
+
+    GameFileHeader expected;
+    GameFileHeader header;
+    FILE *file = fopen(path, "a+b");
+
+    if (file == NULL) {
+        return NULL;
+    }
+    initGameFileHeader(&expected);
+
+    // Every write goes to the end, whatever the position
+    if (fseek(file, 0, SEEK_END) != 0) {
+        fclose(file);
+        return NULL;
+    }
+    if (ftell(file) == 0) {
+        if (fwrite(&expected, sizeof(expected), 1, file) == 1 && fflush(file) == 0) {
+            return file;
+        }
+    } else if (fseek(file, 0, SEEK_SET) == 0 && fread(&header, sizeof(header), 1, file) == 1 &&
+               memcmp(&header, &expected, sizeof(header)) == 0 && dropPartialGame(file, path)) {
+        return file;
+    }
+
+    fclose(file);
+    return NULL;
+}
+
+/**
+ * @brief Append one game to a game file
+ *
+ * The game is flushed at once, so a crash loses at most the game being
+ * written.
+ *
+ * @param file A file from `openGameWriter`
+ * @param columns The 0-based column of every ply
+ * @param moves Number of plies
+ * @return 1 on success, 0 if the game is too long or the write failed
+ */
+int appendGame(FILE *file, const int8_t *columns, int moves) {
+
+    unsigned char entry[MAX_MOVES + 1];
+
+    if (moves < 0 || moves > geometry.cells) {
+        return 0;
+    }
+
+    entry[0] = (unsigned char) moves;
+    for (int i = 0; i < moves; i++) {
+        entry[i + 1] = (unsigned char) columns[i];
+    }
+
+    return fwrite(entry, 1, moves + 1, file) == (size_t) moves + 1 && fflush(file) == 0;
+}
+
+/**
+ * @brief Map a game file into memory and index its games
+ *
+ * The games are walked once to count them and to note where every batch
+ * of REPLAY_BATCH games starts, so replay threads can start anywhere. A
+ * game file must match the current geometry.
+ *
+ * @param path Path of the game file
+ * @return The file, or NULL if it is corrupt or cannot be used with this board geometry
+ */
+GameFile * openGameFile(const char *path) {
+
+    GameFileHeader expected;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(GameFileHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // The mapping stays valid without the descriptor
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    // Reject files of another format, board geometry or number of players
+    initGameFileHeader(&expected);
+    GameFile *file = (GameFile *) calloc(1, sizeof(GameFile));
+    if (file == NULL || memcmp(map, &expected, sizeof(expected)) != 0) {
+        free(file);
+        munmap(map, (size_t) info.st_size);
+        return NULL;
+    }
+
+    file->map = map;
+    file->size = (size_t) info.st_size;
+    file->games = (const unsigned char *) map + sizeof(GameFileHeader);
+
+    // The games are read front to back, first here and then by the replay
+    posix_madvise(map, file->size, POSIX_MADV_SEQUENTIAL);
+
+    size_t length = file->size - sizeof(GameFileHeader);
+    size_t capacity = 0;
+    size_t offset = 0;
+
+    while (offset < length) {
+        int moves = file->games[offset];
+
+        if (moves > geometry.cells) {
+            closeGameFile(file);
+            return NULL;
+        }
+        if (offset + moves + 1 > length) {
+            file->truncated = 1;
+            break;
+        }
+
+        // Note where every batch starts
+        if (file->count % REPLAY_BATCH == 0) {
+            size_t batch = file->count / REPLAY_BATCH;
+
+            if (batch == capacity) {
+                capacity = capacity ? capacity * 2 : 64;
+                uint64_t *batches = realloc(file->batches, capacity * sizeof(uint64_t));
+                if (batches == NULL) {
+                    closeGameFile(file);
+                    return NULL;
+                }
+                file->batches = batches;
+            }
+            file->batches[batch] = offset;
+        }
+
+        file->count++;
+        offset += moves + 1;
+    }
+    file->length = offset;
+
+    return file;
+}
+
+/**
+ * @brief Unmap and free a game file
+ * @param file The file, may be NULL
+ */
+void closeGameFile(GameFile *file) {
+
+    if (file == NULL) {
+        return;
+    }
+
+    munmap(file->map, file->size);
+    free(file->batches);
+    free(file);
+}
+
+/**
+ * @brief Replay one game on the Game bitboards
+ *
+ * @param columns The column of every ply
+ * @param moves Number of plies
+ * @return GAME_WON, GAME_TIE, GAME_ON if unfinished, MOVE_FAILED if invalid
+ */
+static int replayOnGame(const unsigned char *columns, int moves) {
+
+    Game game;
+    int status = GAME_ON;
+
+    initGame(&game);
+    for (int i = 0; i < moves; i++) {
+        if (status != GAME_ON) {
+            return MOVE_FAILED; // A move after the end of the game
+        }
+
+        status = gamePlay(&game, columns[i]);
+        if (status == MOVE_FAILED) {
+            return MOVE_FAILED;
+        }
+    }
+
+    return status;
+}
+
+/**
+ * @brief Replay one game on a character board, like the interactive game
+ *
+ * @param columns The column of every ply
+ * @param moves Number of plies
+ * @return GAME_WON, GAME_TIE, GAME_ON if unfinished, MOVE_FAILED if invalid
+ */
+static int replayOnBoard(const unsigned char *columns, int moves) {
+
+    char board[MAX_ROWS][MAX_COLS];
+    int status = GAME_ON;
+    int played = 0;
+
+    initBoard(board, geometry.rows, geometry.columns);
+    for (int i = 0; i < moves; i++) {
+        if (status != GAME_ON) {
+            return MOVE_FAILED; // A move after the end of the game
+        }
+
+        status = playMove(board, geometry.rows, geometry.columns, NUM_PLAYERS, geometry.connect,
+                          'A' + i % NUM_PLAYERS, columns[i], &played);
+        if (status == MOVE_FAILED) {
+            return MOVE_FAILED;
+        }
+    }
+
+    return status;
+}
+
+/**
+ * @brief Replay batches of games until none are left
+ * @param arg The ReplayWorker of the thread
+ * @return NULL
+ */
+static void * runReplayWorker(void *arg) {
+
+    ReplayWorker *worker = (ReplayWorker *) arg;
+    ReplayPool *pool = worker->pool;
+    const GameFile *file = pool->file;
+    uint64_t batches = (file->count + REPLAY_BATCH - 1) / REPLAY_BATCH;
+
+    for (uint64_t batch = atomic_fetch_add(&pool->next, 1); batch < batches; batch = atomic_fetch_add(&pool->next, 1)) {
+        const unsigned char *entry = file->games + file->batches[batch];
+        uint64_t first = batch * REPLAY_BATCH;
+        uint64_t last = first + REPLAY_BATCH < file->count ? first + REPLAY_BATCH : file->count;
+
+        for (uint64_t index = first; index < last; index++) {
+            int moves = entry[0];
+            int status = pool->method == REPLAY_BOARD ? replayOnBoard(entry + 1, moves) : replayOnGame(entry + 1, moves);
+
+            worker->stats.plies += moves;
+            if (status == GAME_WON) {
+                worker->stats.wins[(moves - 1) % NUM_PLAYERS]++;
+            } else if (status == GAME_TIE) {
+                worker->stats.ties++;
+            } else if (status == GAME_ON) {
+                worker->stats.unfinished++;
+            } else {
+                worker->stats.invalid++;
+            }
+
+            if (pool->visitor != NULL) {
+                pool->visitor(index, entry + 1, moves, status, pool->context);
+            }
+            entry += moves + 1;
+        }
+        worker->stats.games += last - first;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Replay every game of a game file and count the results
+ *
+ * Batches of games are shared by the threads; each thread keeps its own
+ * counts, which are added up at the end.
+ *
+ * @param file The game file
+ * @param threads Number of replay threads
+ * @param method REPLAY_GAME or REPLAY_BOARD
+ * @param visitor Called for every game, may be NULL
+ * @param context Passed to the visitor
+ * @param stats The counts of the whole file
+ * @return 1 if every game is valid, 0 otherwise
+ */
+int replayGames(const GameFile *file, int threads, int method, ReplayVisitor visitor, void *context,
+                ReplayStats *stats) {
+
+    ReplayWorker workers[MAX_THREADS];
+    ReplayPool pool;
+    double start = getTime();
+
+    pool.file = file;
+    pool.method = method;
+    pool.visitor = visitor;
+    pool.context = context;
+    atomic_init(&pool.next, 0);
+
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > MAX_THREADS) {
+        threads = MAX_THREADS;
+    }
+    for (int i = 0; i < threads; i++) {
+        workers[i].pool = &pool;
+        memset(&workers[i].stats, 0, sizeof(ReplayStats));
+    }
+
+    int started = runThreads(threads, runReplayWorker, workers, sizeof(workers[0]));
+
+    memset(stats, 0, sizeof(ReplayStats));
+    for (int i = 0; i < started; i++) {
+        stats->games += workers[i].stats.games;
+        stats->plies += workers[i].stats.plies;
+        for (int player = 0; player < NUM_PLAYERS; player++) {
+            stats->wins[player] += workers[i].stats.wins[player];
+        }
+        stats->ties += workers[i].stats.ties;
+        stats->unfinished += workers[i].stats.unfinished;
+        stats->invalid += workers[i].stats.invalid;
+    }
+    stats->seconds = getTime() - start;
+
+    return stats->invalid == 0;
+}
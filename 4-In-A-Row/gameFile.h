@@ -0,0 +1,70 @@
+/**
+ * @file gameFile.h
+ * @brief Header file for gameFile.c
+ *
+ * A game file stores whole games, not just positions. It is a fixed header
+ * (board geometry and number of players) followed by the games back to
+ * back, each one a byte holding its number of plies and then the 0-based
+ * column of every ply, one byte each. Games are only ever appended, so a
+ * file grows by one `appendGame` call per game and is read straight from a
+ * read-only mapping. A game cut short by a crashed writer can only be at
+ * the end of the file: the reader ignores it, and the next writer cuts it
+ * off before appending, so the games after it stay framed.
+ */
+#ifndef GAME_FILE_H
+#define GAME_FILE_H
+
+#include <stddef.h>
+#include "game.h"
+
+#define GAME_FILE_MAGIC "C4GR"
+#define GAME_FILE_VERSION 1
+#define GAME_FILE_EXTENSION ".c4g"
+#define REPLAY_BATCH 4096          // Games per batch of work handed to a replay thread
+#define REPLAY_GAME 0              // Replay on the Game bitboards with gamePlay
+#define REPLAY_BOARD 1             // Replay on a character board with playMove
+
+typedef struct GameFileHeader {
+    char magic[4];       // GAME_FILE_MAGIC
+    uint32_t version;    // GAME_FILE_VERSION
+    int32_t rows;        // Board geometry the games were played on
+    int32_t columns;
+    int32_t connect;
+    int32_t players;     // Players taking turns, NUM_PLAYERS
+} GameFileHeader;
+
+typedef struct GameFile {
+    void *map;                   // The whole mapped file
+    size_t size;                 // Size of the mapping in bytes
+    const unsigned char *games;  // The first game, right after the header
+    uint64_t count;              // Number of complete games
+    size_t length;               // Bytes taken by the complete games
+    uint64_t *batches;           // Offset from `games` of every REPLAY_BATCH-th game
+    int truncated;               // Set if the last game was cut short
+} GameFile;
+
+typedef struct ReplayStats {
+    uint64_t games;              // Games replayed
+    uint64_t plies;              // Moves played, over every game
+    uint64_t wins[NUM_PLAYERS];  // Games won by each player, from 'A'
+    uint64_t ties;               // Games ending on a full board
+    uint64_t unfinished;         // Games stopped before a result
+    uint64_t invalid;            // Games with an illegal move or a move after the end
+    double seconds;              // Wall-clock time of the replay
+} ReplayStats;
+
+/**
+ * Called for every replayed game, from the replay threads and in no
+ * particular order. `status` is GAME_WON, GAME_TIE, GAME_ON for an
+ * unfinished game or MOVE_FAILED for an invalid one.
+ */
+typedef void (*ReplayVisitor)(uint64_t index, const unsigned char *columns, int moves, int status, void *context);
+
+FILE * openGameWriter(const char *path);
+int appendGame(FILE *file, const int8_t *columns, int moves);
+GameFile * openGameFile(const char *path);
+void closeGameFile(GameFile *file);
+int replayGames(const GameFile *file, int threads, int method, ReplayVisitor visitor, void *context,
+                ReplayStats *stats);
+
+#endif
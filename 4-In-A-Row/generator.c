@@ -0,0 +1,301 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "generator.h"
+#include "codec.h"
+#include "solver.h"
+
+typedef struct GeneratorPool {
+    char (*codes)[CODE_SIZE];  // Encoded boards of the chunk
+    uint64_t first;            // Index of the first board of the chunk
+    int count;                 // Boards in the chunk
+    int kind;                  // Kind of board to generate
+    uint64_t seed;             // Corpus seed
+    atomic_int next;           // Index of the next batch of the chunk
+    atomic_int failed;         // Set when a board was given up, which stops the corpus
+} GeneratorPool;
+
+typedef struct GeneratorWorker {
+    GeneratorPool *pool;
+    GeneratorStats stats;      // Counts of this thread only
+} GeneratorWorker;
+
+static const char *kindNames[] = {"legal", "floating", "turns", "double", "mixed"};
+
+/**
+ * @brief Pick one of the columns of a set of cells at random
+ * @param cells At most one cell per column
+ * @param random The generator state
+ * @return The column, NO_MOVE if the set is empty
+ */
+static int pickColumn(Bitboard cells, uint64_t *random) {
+
+    int columns[MAX_COLS];
+    int count = 0;
+
+    for (int col = 0; col < geometry.columns; col++) {
+        if (cells & BB_COLUMN_MASK(col)) {
+            columns[count++] = col;
+        }
+    }
+
+    return count > 0 ? columns[nextRandom(random) % count] : NO_MOVE;
+}
+
+/**
+ * @brief Play a random game of an exact length
+ *
+ * Every move but the last one is drawn among the moves that do not win,
+ * so the game cannot end early; the last one may be any move. A game that
+ * runs out of such moves is given up.
+ *
+ * @param game Filled with the game
+ * @param plies Number of moves to play
+ * @param random The generator state
+ * @return 1 if the game reached `plies` moves, 0 otherwise
+ */
+static int playRandomGame(Game *game, int plies, uint64_t *random) {
+
+    initGame(game);
+    for (int i = 0; i < plies; i++) {
+        Bitboard possible = (game->mask + BB_BOTTOM_MASK) & BB_BOARD_MASK;
+
+        if (i < plies - 1) {
+            possible &= ~getWinningCells(game->disks[getCurrentPlayer(game)], game->mask, geometry.connect);
+        }
+
+        int col = pickColumn(possible, random);
+        if (col == NO_MOVE) {
+            return 0;
+        }
+        gameMakeMove(game, col);
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Play random moves until both players have a line
+ *
+ * The players keep taking turns after the first line, so the board only
+ * breaks the rule that the game stops at the first win.
+ *
+ * @param game Filled with the game
+ * @param random The generator state
+ * @return 1 if both players have a line, 0 if the board filled up first
+ */
+static int playDoubleWin(Game *game, uint64_t *random) {
+
+    initGame(game);
+    while (game->moves < geometry.cells) {
+        gameMakeMove(game, pickColumn((game->mask + BB_BOTTOM_MASK) & BB_BOARD_MASK, random));
+
+        if (hasConnect(game->disks[0], geometry.connect) && hasConnect(game->disks[1], geometry.connect)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Get the kind of board of a name
+ * @param name "legal", "floating", "turns", "double" or "mixed"
+ * @return The kind, -1 if the name is unknown
+ */
+int parseBoardKind(const char *name) {
+
+    for (int kind = 0; kind <= GENERATE_MIXED; kind++) {
+        if (strcmp(name, kindNames[kind]) == 0) {
+            return kind;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Generate one board of a corpus
+ *
+ * @param seed Corpus seed
+ * @param index Index of the board in the corpus
+ * @param kind Kind of board, GENERATE_MIXED picks `index % GENERATE_MIXED`
+ * @param board Filled with the board
+ * @param retries Incremented for every random game thrown away
+ * @return Number of disks on the board, -1 if no board of this kind was found
+ */
+int generateBoard(uint64_t seed, uint64_t index, int kind, char board[MAX_ROWS][MAX_COLS], uint64_t *retries) {
+
+    uint64_t random = mixSeed(seed ^ mixSeed(index)) | 1;
+    Game game;
+
+    if (kind == GENERATE_MIXED) {
+        kind = (int) (index % GENERATE_MIXED);
+    }
+
+    if (kind == GENERATE_DOUBLE_WIN) {
+        for (int tries = 0; tries < GENERATE_GIVE_UP; tries++) {
+            if (playDoubleWin(&game, &random)) {
+                storeGame(&game, board);
+                return game.moves;
+            }
+            (*retries)++;
+        }
+        return -1;
+    }
+
+    // A raised disk needs a disk to raise, a disk too many needs an empty cell
+    int minPlies = kind == GENERATE_FLOATING ? 1 : 0;
+    int maxPlies = kind == GENERATE_LEGAL ? geometry.cells : geometry.cells - 1;
+    int plies = 0;
+
+    for (int tries = 0; tries < GENERATE_GIVE_UP; tries++) {
+        // Retry with the same length, so long games are as common as short ones,
+        // unless that length seems out of reach on this geometry
+        if (tries % GENERATE_TRIES == 0) {
+            plies = minPlies + (int) (nextRandom(&random) % (uint64_t) (maxPlies - minPlies + 1));
+        }
+
+        if (!playRandomGame(&game, plies, &random)) {
+            (*retries)++;
+            continue;
+        }
+
+        storeGame(&game, board);
+        if (kind == GENERATE_LEGAL) {
+            return game.moves;
+        }
+
+        Bitboard playable = (game.mask + BB_BOTTOM_MASK) & BB_BOARD_MASK;
+        if (kind == GENERATE_TURNS) {
+            // The player who is not to move drops a disk
+            int col = pickColumn(playable, &random);
+            board[geometry.rows - 1 - game.heights[col]][col] = (char) ('A' + (game.moves + 1) % NUM_PLAYERS);
+            return game.moves + 1;
+        }
+
+        // Raise the top disk of a column by one cell, if a column has a disk and room above it
+        int col = pickColumn(playable & ~BB_BOTTOM_MASK, &random);
+        if (col == NO_MOVE) {
+            (*retries)++;
+            continue;
+        }
+
+        int top = geometry.rows - game.heights[col];
+        board[top - 1][col] = board[top][col];
+        board[top][col] = EMPTY_POS;
+        return game.moves;
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Generate batches of boards of the current chunk until none are left
+ * @param arg The GeneratorWorker of the thread
+ * @return NULL
+ */
+static void * runGeneratorWorker(void *arg) {
+
+    GeneratorWorker *worker = (GeneratorWorker *) arg;
+    GeneratorPool *pool = worker->pool;
+    char board[MAX_ROWS][MAX_COLS];
+    int batches = (pool->count + GENERATE_BATCH - 1) / GENERATE_BATCH;
+
+    for (int batch = atomic_fetch_add(&pool->next, 1); batch < batches; batch = atomic_fetch_add(&pool->next, 1)) {
+        int first = batch * GENERATE_BATCH;
+        int last = first + GENERATE_BATCH < pool->count ? first + GENERATE_BATCH : pool->count;
+
+        for (int i = first; i < last && !atomic_load(&pool->failed); i++) {
+            uint64_t index = pool->first + (uint64_t) i;
+            int kind = pool->kind == GENERATE_MIXED ? (int) (index % GENERATE_MIXED) : pool->kind;
+
+            int disks = generateBoard(pool->seed, index, kind, board, &worker->stats.retries);
+            if (disks < 0) {
+                // The other boards of this kind would most likely be given up too
+                worker->stats.failed++;
+                atomic_store(&pool->failed, 1);
+                break;
+            }
+            encodeBoard((const char (*)[MAX_COLS]) board, geometry.rows, geometry.columns, pool->codes[i]);
+            worker->stats.boards++;
+            worker->stats.kinds[kind]++;
+            worker->stats.plies[disks]++;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Write a corpus of random boards, one encoded board per line
+ *
+ * The boards are generated a chunk at a time: batches of the chunk are
+ * shared by the threads, then the calling thread writes the chunk in
+ * order before the next one starts.
+ *
+ * @param output The file to write
+ * @param count Number of boards
+ * @param kind Kind of board, GENERATE_LEGAL to GENERATE_MIXED
+ * @param threads Number of generator threads
+ * @param seed Corpus seed
+ * @param stats Counts of the whole corpus
+ * @return 1 on success, 0 if a board was given up, memory ran out or the output failed
+ */
+int generateBoards(FILE *output, uint64_t count, int kind, int threads, uint64_t seed, GeneratorStats *stats) {
+
+    GeneratorWorker workers[MAX_THREADS];
+    GeneratorPool pool;
+    double start = getTime();
+    int ok = 1;
+
+    memset(stats, 0, sizeof(GeneratorStats));
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > MAX_THREADS) {
+        threads = MAX_THREADS;
+    }
+
+    pool.codes = malloc(sizeof(*pool.codes) * GENERATE_CHUNK);
+    if (pool.codes == NULL) {
+        return 0;
+    }
+    pool.kind = kind;
+    pool.seed = seed;
+
+    for (uint64_t first = 0; first < count && ok; first += GENERATE_CHUNK) {
+        pool.first = first;
+        pool.count = count - first < GENERATE_CHUNK ? (int) (count - first) : GENERATE_CHUNK;
+        atomic_init(&pool.next, 0);
+        atomic_init(&pool.failed, 0);
+        for (int i = 0; i < threads; i++) {
+            workers[i].pool = &pool;
+            memset(&workers[i].stats, 0, sizeof(GeneratorStats));
+        }
+
+        int started = runThreads(threads, runGeneratorWorker, workers, sizeof(workers[0]));
+
+        for (int i = 0; i < started; i++) {
+            stats->boards += workers[i].stats.boards;
+            stats->retries += workers[i].stats.retries;
+            stats->failed += workers[i].stats.failed;
+            for (int k = 0; k < GENERATE_MIXED; k++) {
+                stats->kinds[k] += workers[i].stats.kinds[k];
+            }
+            for (int disks = 0; disks <= MAX_MOVES; disks++) {
+                stats->plies[disks] += workers[i].stats.plies[disks];
+            }
+        }
+
+        // A chunk with a board given up is not written
+        ok = stats->failed == 0;
+        for (int i = 0; i < pool.count && ok; i++) {
+            ok = fputs(pool.codes[i], output) >= 0 && fputc('\n', output) != EOF;
+        }
+    }
+
+    free(pool.codes);
+    stats->seconds = getTime() - start;
+    return ok && fflush(output) == 0;
+}
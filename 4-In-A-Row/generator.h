@@ -0,0 +1,48 @@
+/**
+ * @file generator.h
+ * @brief Header file for generator.c
+ *
+ * Produces corpora of boards in the `encode()` format for benchmarks and
+ * fuzzing. Legal boards come from random games whose length is drawn
+ * uniformly from 0 to the number of cells, so every ply count is equally
+ * common; the game only ends on a win at its last move. Illegal boards are
+ * built from legal ones, one kind of fault each, matching the checks of
+ * `isValidBoard`: a disk raised above an empty cell, a disk too many for a
+ * player, or lines for both players. A length that keeps failing is drawn
+ * again, and a board that cannot be made on the geometry at all (say lines
+ * for both players on a single row too short for two) is given up.
+ *
+ * Board i only depends on the seed and on i, so a corpus is the same on
+ * any number of threads. Boards are generated in chunks by a pool of
+ * threads and written in order, one per line.
+ */
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <stdint.h>
+#include "game.h"
+
+#define GENERATE_LEGAL 0         // A position of a legal game, stopped at the first win
+#define GENERATE_FLOATING 1      // A disk raised by one cell, leaving a gap below it
+#define GENERATE_TURNS 2         // One disk more for the player who moved last
+#define GENERATE_DOUBLE_WIN 3    // Both players have a line
+#define GENERATE_MIXED 4         // The four kinds above in turn
+#define GENERATE_BATCH 1024      // Boards handed to a thread at a time
+#define GENERATE_CHUNK 65536     // Boards generated before they are written
+#define GENERATE_TRIES 64        // Random games of one length played before another length is drawn
+#define GENERATE_GIVE_UP (1 << 20) // Random games played for one board before it is given up
+
+typedef struct GeneratorStats {
+    uint64_t boards;                  // Boards written
+    uint64_t kinds[GENERATE_MIXED];   // Boards of every kind
+    uint64_t plies[MAX_MOVES + 1];    // Boards by number of disks
+    uint64_t retries;                 // Random games thrown away
+    uint64_t failed;                  // Boards given up after GENERATE_GIVE_UP games
+    double seconds;                   // Wall-clock time
+} GeneratorStats;
+
+int parseBoardKind(const char *name);
+int generateBoard(uint64_t seed, uint64_t index, int kind, char board[MAX_ROWS][MAX_COLS], uint64_t *retries);
+int generateBoards(FILE *output, uint64_t count, int kind, int threads, uint64_t seed, GeneratorStats *stats);
+
+#endif
@@ -0,0 +1,246 @@
+#define _POSIX_C_SOURCE 200809L
+#include "instrument.h"
+
+// Nothing here is compiled without -DINSTRUMENT
+#ifdef INSTRUMENT
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "game.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROBE_CLOCK "rdtsc"
+#else
+#define PROBE_CLOCK "ns"
+#endif
+
+#define DEPTH_SIZE (MAX_MOVES + 1) // Buckets of a depth histogram, one per ply
+
+typedef struct ProbeBlock {
+    // Only the owning thread writes, so relaxed loads and stores are enough
+    atomic_ullong calls[PROBE_COUNT];
+    atomic_ullong ticks[PROBE_COUNT];
+    atomic_ullong depths[DEPTH_COUNT][DEPTH_SIZE];
+    struct ProbeBlock *next;
+} ProbeBlock;
+
+static const char *probeNames[PROBE_COUNT] = {
+    "checkForConnect", "hasConnect", "getCommonLineCells", "countWins", "getBottomEmptyPos",
+    "encode", "decode", "isValidBoard", "getBoardStats", "canReplayStacks"
+};
+static const char *depthNames[DEPTH_COUNT] = {"negamax", "search", "perft", "replay"};
+
+static pthread_mutex_t blocksLock = PTHREAD_MUTEX_INITIALIZER;
+static ProbeBlock *blocks;                 // Every thread's block, kept after the thread ends
+static _Thread_local ProbeBlock *localBlock;
+static uint64_t startTicks;                // Clock ticks and time when the probes were started
+static struct timespec startTime;
+
+/**
+ * @brief Read the probe clock
+ * @return Clock ticks: the time stamp counter on x86, nanoseconds elsewhere
+ */
+static inline uint64_t readTicks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Get the block of the calling thread, creating it on first use
+ * @return The block, NULL if memory ran out
+ */
+static ProbeBlock * getBlock(void) {
+
+    if (localBlock == NULL) {
+        localBlock = calloc(1, sizeof(ProbeBlock));
+        if (localBlock == NULL) {
+            return NULL;
+        }
+
+        pthread_mutex_lock(&blocksLock);
+        localBlock->next = blocks;
+        blocks = localBlock;
+        pthread_mutex_unlock(&blocksLock);
+    }
+
+    return localBlock;
+}
+
+/**
+ * @brief Add to a counter of the calling thread's block
+ * @param counter The counter
+ * @param amount Amount to add
+ */
+static inline void addCount(atomic_ullong *counter, uint64_t amount) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + amount,
+                          memory_order_relaxed);
+}
+
+/**
+ * @brief Enter a probed function
+ * @param probe The probed function, PROBE_CHECK_FOR_CONNECT to PROBE_COUNT - 1
+ * @return The timer to stop when the function returns
+ */
+ProbeTimer startProbe(int probe) {
+
+    ProbeTimer timer = {probe, readTicks()};
+    return timer;
+}
+
+/**
+ * @brief Leave a probed function and count the call and its ticks
+ * @param timer The timer from startProbe
+ */
+void stopProbe(ProbeTimer *timer) {
+
+    uint64_t ticks = readTicks() - timer->start;
+    ProbeBlock *block = getBlock();
+
+    if (block != NULL) {
+        addCount(&block->calls[timer->probe], 1);
+        addCount(&block->ticks[timer->probe], ticks);
+    }
+}
+
+/**
+ * @brief Count one node of a recursive search at a depth
+ * @param histogram DEPTH_NEGAMAX to DEPTH_COUNT - 1
+ * @param depth The depth, clamped to the histogram
+ */
+void recordDepth(int histogram, int depth) {
+
+    ProbeBlock *block = getBlock();
+
+    if (block != NULL) {
+        addCount(&block->depths[histogram][depth < 0 ? 0 : depth < DEPTH_SIZE ? depth : DEPTH_SIZE - 1], 1);
+    }
+}
+
+/**
+ * @brief Write the counts of every thread, added up, as one JSON object
+ *
+ * Counts still being updated by other threads are read as they are, so a
+ * dump taken while the program runs is a consistent sum of each counter but
+ * not a snapshot of a single instant.
+ */
+void dumpProbes(void) {
+
+    static pthread_mutex_t dumpLock = PTHREAD_MUTEX_INITIALIZER;
+    unsigned long long calls[PROBE_COUNT] = {0};
+    unsigned long long ticks[PROBE_COUNT] = {0};
+    unsigned long long depths[DEPTH_COUNT][DEPTH_SIZE] = {{0}};
+    int threads = 0;
+    struct timespec now;
+
+    pthread_mutex_lock(&dumpLock);
+    pthread_mutex_lock(&blocksLock);
+    for (ProbeBlock *block = blocks; block != NULL; block = block->next) {
+        for (int probe = 0; probe < PROBE_COUNT; probe++) {
+            calls[probe] += atomic_load_explicit(&block->calls[probe], memory_order_relaxed);
+            ticks[probe] += atomic_load_explicit(&block->ticks[probe], memory_order_relaxed);
+        }
+        for (int histogram = 0; histogram < DEPTH_COUNT; histogram++) {
+            for (int depth = 0; depth < DEPTH_SIZE; depth++) {
+                depths[histogram][depth] += atomic_load_explicit(&block->depths[histogram][depth], memory_order_relaxed);
+            }
+        }
+        threads++;
+    }
+    pthread_mutex_unlock(&blocksLock);
+
+    // Ticks per second of the probe clock, measured since the start
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double seconds = (double) (now.tv_sec - startTime.tv_sec) + (now.tv_nsec - startTime.tv_nsec) / 1e9;
+    double rate = seconds > 0 ? (double) (readTicks() - startTicks) / seconds : 0;
+
+    const char *path = getenv(PROBES_FILE_VARIABLE);
+    FILE *output = path != NULL && path[0] != '\0' ? fopen(path, "w") : stderr;
+    if (output == NULL) {
+        output = stderr;
+    }
+
+    fprintf(output, "{\"clock\": \"%s\", \"ticksPerSecond\": %.0f, \"seconds\": %.6f, \"threads\": %d,\n",
+            PROBE_CLOCK, rate, seconds, threads);
+    fprintf(output, " \"probes\": {");
+    for (int probe = 0; probe < PROBE_COUNT; probe++) {
+        fprintf(output, "%s\n  \"%s\": {\"calls\": %llu, \"ticks\": %llu, \"ticksPerCall\": %.1f}",
+                probe > 0 ? "," : "", probeNames[probe], calls[probe], ticks[probe],
+                calls[probe] > 0 ? (double) ticks[probe] / calls[probe] : 0.0);
+    }
+    fprintf(output, "},\n \"depths\": {");
+    for (int histogram = 0; histogram < DEPTH_COUNT; histogram++) {
+        // Leave out the empty buckets past the deepest node
+        int size = DEPTH_SIZE;
+        while (size > 0 && depths[histogram][size - 1] == 0) {
+            size--;
+        }
+
+        fprintf(output, "%s\n  \"%s\": [", histogram > 0 ? "," : "", depthNames[histogram]);
+        for (int depth = 0; depth < size; depth++) {
+            fprintf(output, "%s%llu", depth > 0 ? ", " : "", depths[histogram][depth]);
+        }
+        fprintf(output, "]");
+    }
+    fprintf(output, "}}\n");
+
+    if (output != stderr) {
+        fclose(output);
+    } else {
+        fflush(output);
+    }
+    pthread_mutex_unlock(&dumpLock);
+}
+
+/**
+ * @brief Dump the counts every time SIGUSR1 arrives
+ * @param arg The signal set holding SIGUSR1
+ * @return NULL, never returns while the program runs
+ */
+static void * runDumpThread(void *arg) {
+
+    const sigset_t *signals = (const sigset_t *) arg;
+    int received;
+
+    while (sigwait(signals, &received) == 0) {
+        dumpProbes();
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Start the clock of the probes and arrange for the dumps
+ *
+ * SIGUSR1 is blocked in the calling thread, and so in every thread started
+ * after it, and taken by a thread of its own; a dump never runs inside a
+ * signal handler. Must be called first thing in main.
+ */
+void startProbes(void) {
+
+    static sigset_t signals;
+    pthread_t id;
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    startTicks = readTicks();
+
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGUSR1);
+    if (pthread_sigmask(SIG_BLOCK, &signals, NULL) == 0 &&
+        pthread_create(&id, NULL, runDumpThread, &signals) == 0) {
+        pthread_detach(id);
+    }
+
+    atexit(dumpProbes);
+}
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ * @file instrument.h
+ * @brief Header file for instrument.c
+ *
+ * Probes count the calls of the hot functions and the clock ticks spent in
+ * them, and depth histograms count the nodes a recursive search visits at
+ * every ply. They only exist in builds made with -DINSTRUMENT: otherwise
+ * every macro below expands to nothing, so the hooks can stay in the code.
+ *
+ * A probe is placed at the top of a function and stops when the function
+ * returns, whatever the return, so the ticks of a probe include those of
+ * the probed functions it calls. The ticks are read with rdtsc on x86 and
+ * are nanoseconds elsewhere. Every thread counts into a block of its own,
+ * and the blocks are added up when they are dumped as JSON: at exit, and
+ * every time the process gets SIGUSR1. The dump goes to the file named by
+ * the C4_PROBES environment variable, or to stderr.
+ */
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <stdint.h>
+
+// Probed functions
+#define PROBE_CHECK_FOR_CONNECT 0
+#define PROBE_HAS_CONNECT 1
+#define PROBE_COMMON_LINE_CELLS 2
+#define PROBE_COUNT_WINS 3
+#define PROBE_BOTTOM_EMPTY_POS 4
+#define PROBE_ENCODE 5
+#define PROBE_DECODE 6
+#define PROBE_IS_VALID_BOARD 7
+#define PROBE_BOARD_STATS 8
+#define PROBE_REPLAY_STACKS 9
+#define PROBE_COUNT 10
+
+// Depth histograms
+#define DEPTH_NEGAMAX 0       // Solver nodes by ply
+#define DEPTH_SEARCH 1        // Anytime search nodes by ply
+#define DEPTH_PERFT 2         // Perft nodes by ply
+#define DEPTH_REPLAY 3        // Turns at which the replay of isValidBoard backed off
+#define DEPTH_COUNT 4
+
+#define PROBES_FILE_VARIABLE "C4_PROBES"
+
+#ifdef INSTRUMENT
+
+typedef struct ProbeTimer {
+    int probe;                // The probed function
+    uint64_t start;           // Clock ticks when it was entered
+} ProbeTimer;
+
+ProbeTimer startProbe(int probe);
+void stopProbe(ProbeTimer *timer);
+void recordDepth(int histogram, int depth);
+void startProbes(void);
+void dumpProbes(void);
+
+#define PROBE(probe) ProbeTimer probeTimer __attribute__((cleanup(stopProbe))) = startProbe(probe)
+#define PROBE_DEPTH(histogram, depth) recordDepth(histogram, depth)
+#define START_PROBES() startProbes()
+
+#else
+
+#define PROBE(probe) ((void) 0)
+#define PROBE_DEPTH(histogram, depth) ((void) 0)
+#define START_PROBES() ((void) 0)
+
+#endif
+
+#endif
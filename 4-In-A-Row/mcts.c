@@ -0,0 +1,307 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdatomic.h>
+#include "mcts.h"
+#include "solver.h"
+
+typedef struct MctsWorker {
+    const Game *root;           // Position searched by every thread
+    const MctsConfig *config;
+    MctsNode *nodes;            // The tree of this thread, nodes[0] is the root
+    int count;                  // Nodes in use
+    int capacity;               // Nodes allocated
+    long budget;                // Playouts of all threads together, 0 for no limit
+    atomic_long *taken;         // Playouts claimed so far by all threads together
+    double deadline;            // Time to stop at, 0 for no limit
+    uint64_t random;            // State of the playout generator
+    unsigned long long playouts;
+    int failed;                 // Set if the root could not be allocated
+} MctsWorker;
+
+/**
+ * @brief Fill a configuration with the defaults
+ *
+ * The defaults run MCTS_DEFAULT_PLAYOUTS playouts on one thread.
+ *
+ * @param config The configuration
+ */
+void initMctsConfig(MctsConfig *config) {
+    config->playouts = 0;
+    config->milliseconds = 0;
+    config->threads = 1;
+    config->exploration = MCTS_EXPLORATION;
+    config->seed = 0x9E3779B97F4A7C15ULL;
+}
+
+/**
+ * @brief Add a node for every playable column of a leaf
+ *
+ * Children are added center first. The tree grows by doubling up to
+ * MCTS_MAX_NODES nodes.
+ *
+ * @param worker The worker owning the tree
+ * @param leaf Index of the leaf
+ * @param game The position of the leaf
+ * @return 1 if the children were added, 0 if the tree is full
+ */
+static int expandNode(MctsWorker *worker, int leaf, const Game *game) {
+
+    int needed = worker->count + geometry.columns;
+
+    if (needed > worker->capacity) {
+        int capacity = worker->capacity * 2;
+        if (capacity > MCTS_MAX_NODES) {
+            capacity = MCTS_MAX_NODES;
+        }
+
+        MctsNode *nodes = needed <= capacity ? realloc(worker->nodes, capacity * sizeof(MctsNode)) : NULL;
+        if (nodes == NULL) {
+            return 0; // Keep the tree as it is and play out from the leaf
+        }
+        worker->nodes = nodes;
+        worker->capacity = capacity;
+    }
+
+    int first = worker->count;
+    for (int i = 0; i < geometry.columns; i++) {
+        int col = geometry.columns / 2 + (1 - 2 * (i % 2)) * (i + 1) / 2;
+
+        if (canPlay(game, col)) {
+            MctsNode *child = &worker->nodes[worker->count++];
+            child->firstChild = 0;
+            child->childCount = 0;
+            child->move = (int8_t) col;
+            child->visits = 0;
+            child->score = 0;
+        }
+    }
+
+    worker->nodes[leaf].firstChild = first;
+    worker->nodes[leaf].childCount = (int8_t) (worker->count - first);
+    return 1;
+}
+
+/**
+ * @brief Pick the child to follow with UCT
+ *
+ * An unvisited child is always tried first. Otherwise the child with the
+ * best average result plus exploration bonus is taken.
+ *
+ * @param nodes The tree
+ * @param parent Index of an expanded node
+ * @param exploration UCT exploration constant
+ * @return Index of the chosen child
+ */
+static int selectChild(const MctsNode *nodes, int parent, double exploration) {
+
+    const MctsNode *node = &nodes[parent];
+    double logVisits = log((double) node->visits);
+    double bestValue = -1;
+    int best = node->firstChild;
+
+    for (int i = node->firstChild; i < node->firstChild + node->childCount; i++) {
+        if (nodes[i].visits == 0) {
+            return i;
+        }
+
+        double value = nodes[i].score / (2.0 * nodes[i].visits) + exploration * sqrt(logVisits / nodes[i].visits);
+        if (value > bestValue) {
+            bestValue = value;
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * @brief Finish a game with uniformly random moves
+ *
+ * @param game The game, it must still be on
+ * @param random The generator state
+ * @return The index of the winner, -1 for a draw
+ */
+static int playOut(Game *game, uint64_t *random) {
+
+    int columns[MAX_COLS];
+
+    for (;;) {
+        int count = 0;
+
+        for (int col = 0; col < geometry.columns; col++) {
+            if (game->heights[col] < geometry.rows) {
+                columns[count++] = col;
+            }
+        }
+
+        int player = getCurrentPlayer(game);
+        int status = gamePlay(game, columns[nextRandom(random) % count]);
+
+        if (status == GAME_WON) {
+            return player;
+        }
+        if (status == GAME_TIE) {
+            return -1;
+        }
+    }
+}
+
+/**
+ * @brief Run one playout: select, expand, play out and back up the result
+ * @param worker The worker
+ */
+static void runPlayout(MctsWorker *worker) {
+
+    Game game = *worker->root;
+    int path[MAX_MOVES + 1];
+    int depth = 0;
+    int node = 0;
+    int status = GAME_ON;
+    int winner;
+
+    path[depth++] = node;
+
+    // Follow the tree until a new node or the end of the game is reached
+    while (status == GAME_ON) {
+        if (worker->nodes[node].firstChild == 0 && !expandNode(worker, node, &game)) {
+            break;
+        }
+
+        node = selectChild(worker->nodes, node, worker->config->exploration);
+        path[depth++] = node;
+        status = gamePlay(&game, worker->nodes[node].move);
+
+        if (worker->nodes[node].visits == 0) {
+            break;
+        }
+    }
+
+    if (status == GAME_WON) {
+        winner = (game.moves - 1) % NUM_PLAYERS;
+    } else if (status == GAME_TIE) {
+        winner = -1;
+    } else {
+        winner = playOut(&game, &worker->random);
+    }
+
+    // Credit every node to the player who made its move
+    worker->nodes[0].visits++;
+    for (int i = 1; i < depth; i++) {
+        MctsNode *step = &worker->nodes[path[i]];
+        int mover = (worker->root->moves + i - 1) % NUM_PLAYERS;
+
+        step->visits++;
+        step->score += winner == mover ? 2 : winner < 0 ? 1 : 0;
+    }
+    worker->playouts++;
+}
+
+/**
+ * @brief Grow one tree until the shared budget is spent
+ * @param arg The MctsWorker of the thread
+ * @return NULL
+ */
+static void * runMctsWorker(void *arg) {
+
+    MctsWorker *worker = (MctsWorker *) arg;
+
+    worker->capacity = 1024;
+    worker->nodes = (MctsNode *) malloc(worker->capacity * sizeof(MctsNode));
+    if (worker->nodes == NULL) {
+        worker->failed = 1;
+        return NULL;
+    }
+
+    worker->count = 1;
+    memset(&worker->nodes[0], 0, sizeof(MctsNode));
+    worker->nodes[0].move = NO_MOVE;
+
+    // Every playout is claimed from the shared budget, so the threads that run share all of it
+    while (worker->budget == 0 || atomic_fetch_add(worker->taken, 1) < worker->budget) {
+        runPlayout(worker);
+
+        // Reading the clock on every playout would cost more than the playout
+        if (worker->deadline > 0 && worker->playouts % MCTS_CLOCK_INTERVAL == 0 && getTime() >= worker->deadline) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Choose a move with Monte Carlo Tree Search
+ *
+ * Runs until the playout budget or the time limit is spent, whichever
+ * comes first, on `config->threads` independent trees. The move played
+ * most often from the root wins.
+ *
+ * @param game The game to search, left unchanged
+ * @param config The budget and search settings
+ * @param result The chosen column and the statistics of the search
+ * @return 1 on success, 0 if memory ran out
+ */
+int searchMcts(const Game *game, const MctsConfig *config, MctsResult *result) {
+
+    MctsWorker workers[MAX_THREADS];
+    int count = config->threads < 1 ? 1 : config->threads > MAX_THREADS ? MAX_THREADS : config->threads;
+    long playouts = config->playouts == 0 && config->milliseconds == 0 ? MCTS_DEFAULT_PLAYOUTS : config->playouts;
+    double start = getTime();
+    atomic_long taken;
+    int ok = 1;
+
+    memset(result, 0, sizeof(MctsResult));
+    result->bestMove = NO_MOVE;
+
+    // A finished game has no move to choose
+    int previous = (game->moves + NUM_PLAYERS - 1) % NUM_PLAYERS;
+    if (hasConnect(game->disks[previous], geometry.connect) || game->moves == geometry.cells) {
+        return 1;
+    }
+
+    atomic_init(&taken, 0);
+    for (int i = 0; i < count; i++) {
+        workers[i].root = game;
+        workers[i].config = config;
+        workers[i].nodes = NULL;
+        workers[i].budget = playouts;
+        workers[i].taken = &taken;
+        workers[i].deadline = config->milliseconds > 0 ? start + config->milliseconds / 1000.0 : 0;
+        workers[i].random = (config->seed ^ 0xD1B54A32D192ED03ULL * (uint64_t) (i + 1)) | 1;
+        workers[i].playouts = 0;
+        workers[i].failed = 0;
+    }
+
+    int started = runThreads(count, runMctsWorker, workers, sizeof(workers[0]));
+
+    // Add up the root statistics of every tree
+    unsigned long scores[MAX_COLS] = {0};
+    for (int i = 0; i < started; i++) {
+        const MctsWorker *worker = &workers[i];
+
+        ok &= !worker->failed;
+        if (worker->failed) {
+            continue;
+        }
+        for (int child = worker->nodes[0].firstChild; child < worker->nodes[0].firstChild + worker->nodes[0].childCount; child++) {
+            result->visits[worker->nodes[child].move] += worker->nodes[child].visits;
+            scores[worker->nodes[child].move] += worker->nodes[child].score;
+        }
+        result->playouts += worker->playouts;
+        result->nodes += worker->count;
+        free(worker->nodes);
+    }
+
+    for (int col = 0; col < geometry.columns; col++) {
+        if (result->visits[col] > 0 && (result->bestMove == NO_MOVE || result->visits[col] > result->visits[result->bestMove])) {
+            result->bestMove = col;
+        }
+    }
+    if (result->bestMove != NO_MOVE) {
+        result->winRate = scores[result->bestMove] / (2.0 * result->visits[result->bestMove]);
+    }
+
+    result->seconds = getTime() - start;
+    return ok;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file mcts.h
+ * @brief Header file for mcts.c
+ *
+ * A Monte Carlo Tree Search player for boards too large to solve. Every
+ * playout walks down the tree with UCT, adds the children of the leaf it
+ * reached and finishes the game with random moves. Threads search
+ * independent trees of the same root (root parallelism) and their root
+ * statistics are added up at the end. The only thing they share while
+ * searching is the count of playouts claimed from the budget.
+ */
+#ifndef MCTS_H
+#define MCTS_H
+
+#include "game.h"
+
+#define MCTS_EXPLORATION 1.41            // Default UCT exploration constant, about sqrt(2)
+#define MCTS_DEFAULT_PLAYOUTS 100000     // Budget used when neither playouts nor time are set
+#define MCTS_MAX_NODES (1 << 22)         // Nodes per tree; full trees keep playing out from their leaves
+#define MCTS_CLOCK_INTERVAL 256          // Playouts between two deadline checks
+
+typedef struct MctsNode {
+    int32_t firstChild;   // Index of the first child, 0 while the node is not expanded
+    int8_t childCount;    // Number of children, one per playable column
+    int8_t move;          // Column played to reach the node
+    uint32_t visits;      // Playouts through the node
+    uint32_t score;       // 2 per win and 1 per draw, for the player who made `move`
+} MctsNode;
+
+typedef struct MctsConfig {
+    long playouts;        // Playouts in total, 0 for no limit
+    int milliseconds;     // Time limit, 0 for no limit
+    int threads;          // Number of independent trees
+    double exploration;   // UCT exploration constant
+    uint64_t seed;        // Seed of the random playouts
+} MctsConfig;
+
+typedef struct MctsResult {
+    int bestMove;                    // Most visited root column, NO_MOVE if the game is over
+    double winRate;                  // Average result of the best column, 1 for a sure win
+    unsigned long visits[MAX_COLS];  // Root visits of every column, all trees
+    unsigned long long playouts;     // Playouts run by all threads
+    unsigned long long nodes;        // Tree nodes created by all threads
+    double seconds;                  // Wall-clock time of the search
+} MctsResult;
+
+void initMctsConfig(MctsConfig *config);
+int searchMcts(const Game *game, const MctsConfig *config, MctsResult *result);
+
+#endif
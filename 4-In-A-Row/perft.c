@@ -0,0 +1,305 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "perft.h"
+#include "solver.h"
+#include "instrument.h"
+
+#define SPLIT_DEPTH 2 // Plies expanded on the calling thread before the work is shared
+
+typedef struct PerftTasks {
+    Game *games;                  // Positions at the split depth
+    int count;                    // Number of positions
+    atomic_int next;              // Index of the next position to take
+    int depth;                    // Plies left to search below each position
+    int backend;                  // PERFT_GAME or PERFT_BOARD
+    atomic_ullong leaves;         // Continuations found by all threads
+    atomic_ullong nodes;          // Moves made by all threads
+} PerftTasks;
+
+/**
+ * @brief Count the continuations of a game on its bitboards
+ *
+ * @param game The game, left unchanged
+ * @param depth Plies to play
+ * @param nodes Incremented once per move made
+ * @return Number of continuations of exactly `depth` plies
+ */
+unsigned long long perftGame(Game *game, int depth, unsigned long long *nodes) {
+
+    unsigned long long leaves = 0;
+
+    PROBE_DEPTH(DEPTH_PERFT, game->moves);
+    if (depth == 0) {
+        return 1;
+    }
+
+    for (int col = 0; col < geometry.columns; col++) {
+        if (!canPlay(game, col)) {
+            continue;
+        }
+
+        int player = getCurrentPlayer(game);
+        gameMakeMove(game, col);
+        (*nodes)++;
+
+        // A winning move ends the game, so only a last-ply win is a leaf
+        if (depth == 1) {
+            leaves++;
+        } else if (!hasConnect(game->disks[player], geometry.connect)) {
+            leaves += perftGame(game, depth - 1, nodes);
+        }
+
+        gameUnmakeMove(game);
+    }
+
+    return leaves;
+}
+
+/**
+ * @brief Count the continuations of a character board
+ *
+ * Uses the same primitives as the interactive game: `makeMove`,
+ * `checkLastMove` and `undoMove`.
+ *
+ * @param board The 2D board array, left unchanged
+ * @param moves Number of disks on the board, decides whose turn it is
+ * @param depth Plies to play
+ * @param nodes Incremented once per move made
+ * @return Number of continuations of exactly `depth` plies
+ */
+unsigned long long perftBoard(char board[MAX_ROWS][MAX_COLS], int moves, int depth, unsigned long long *nodes) {
+
+    unsigned long long leaves = 0;
+    char player = 'A' + moves % NUM_PLAYERS;
+
+    PROBE_DEPTH(DEPTH_PERFT, moves);
+    if (depth == 0) {
+        return 1;
+    }
+
+    for (int col = 0; col < geometry.columns; col++) {
+        int row = makeMove(board, geometry.rows, geometry.columns, NUM_PLAYERS, player, col);
+        if (row == MOVE_FAILED) {
+            continue;
+        }
+        (*nodes)++;
+
+        // A winning move ends the game, so only a last-ply win is a leaf
+        if (depth == 1) {
+            leaves++;
+        } else {
+            if (!checkLastMove(board, geometry.rows, geometry.columns, geometry.connect, row, col)) {
+                leaves += perftBoard(board, moves + 1, depth - 1, nodes);
+            }
+        }
+
+        undoMove(board, geometry.rows, geometry.columns, col);
+    }
+
+    return leaves;
+}
+
+/**
+ * @brief Count the continuations below one split position
+ * @param game The position, left unchanged
+ * @param depth Plies to play
+ * @param backend PERFT_GAME or PERFT_BOARD
+ * @param nodes Incremented once per move made
+ * @return Number of continuations of exactly `depth` plies
+ */
+static unsigned long long perftTask(Game *game, int depth, int backend, unsigned long long *nodes) {
+
+    if (backend == PERFT_BOARD) {
+        char board[MAX_ROWS][MAX_COLS];
+        storeGame(game, board);
+        return perftBoard(board, game->moves, depth, nodes);
+    }
+
+    return perftGame(game, depth, nodes);
+}
+
+/**
+ * @brief Take split positions one at a time until none are left
+ * @param arg The shared task list (PerftTasks *)
+ * @return NULL
+ */
+static void * runPerftWorker(void *arg) {
+
+    PerftTasks *tasks = (PerftTasks *) arg;
+    unsigned long long leaves = 0;
+    unsigned long long nodes = 0;
+    int index;
+
+    while ((index = atomic_fetch_add(&tasks->next, 1)) < tasks->count) {
+        leaves += perftTask(&tasks->games[index], tasks->depth, tasks->backend, &nodes);
+    }
+
+    atomic_fetch_add(&tasks->leaves, leaves);
+    atomic_fetch_add(&tasks->nodes, nodes);
+    return NULL;
+}
+
+/**
+ * @brief Collect the positions `plies` moves below a game
+ *
+ * Lines ended by a win before the split depth are dropped; they have no
+ * continuation that reaches the full depth.
+ *
+ * @param game The game, left unchanged
+ * @param plies Plies to play
+ * @param games Array to append the positions to
+ * @param count Number of positions in the array, updated
+ * @param nodes Incremented once per move made
+ */
+static void collectSplit(Game *game, int plies, Game *games, int *count, unsigned long long *nodes) {
+
+    if (plies == 0) {
+        games[(*count)++] = *game;
+        return;
+    }
+
+    for (int col = 0; col < geometry.columns; col++) {
+        if (!canPlay(game, col)) {
+            continue;
+        }
+
+        int player = getCurrentPlayer(game);
+        gameMakeMove(game, col);
+        (*nodes)++;
+
+        if (!hasConnect(game->disks[player], geometry.connect)) {
+            collectSplit(game, plies - 1, games, count, nodes);
+        }
+        gameUnmakeMove(game);
+    }
+}
+
+/**
+ * @brief Count the continuations of a game, split across threads
+ *
+ * The first plies are expanded on the calling thread; the positions they
+ * reach are then shared by `threads` workers.
+ *
+ * @param game The game to start from, nobody may have won yet
+ * @param depth Plies to play
+ * @param threads Number of threads
+ * @param backend PERFT_GAME or PERFT_BOARD
+ * @param result Leaves, moves made and time
+ * @return 1 on success, 0 if memory ran out
+ */
+int runPerftSearch(const Game *game, int depth, int threads, int backend, PerftResult *result) {
+
+    Game root = *game;
+    unsigned long long nodes = 0;
+    double start = getTime();
+
+    // Shallow searches are not worth splitting
+    if (depth <= SPLIT_DEPTH || threads <= 1) {
+        result->leaves = perftTask(&root, depth, backend, &nodes);
+        result->nodes = nodes;
+        result->seconds = getTime() - start;
+        return 1;
+    }
+
+    int maxTasks = 1;
+    for (int i = 0; i < SPLIT_DEPTH; i++) {
+        maxTasks *= geometry.columns;
+    }
+
+    PerftTasks tasks;
+    tasks.games = (Game *) malloc(maxTasks * sizeof(Game));
+    if (tasks.games == NULL) {
+        return 0;
+    }
+    tasks.count = 0;
+    tasks.depth = depth - SPLIT_DEPTH;
+    tasks.backend = backend;
+    atomic_init(&tasks.next, 0);
+    atomic_init(&tasks.leaves, 0);
+    atomic_init(&tasks.nodes, 0);
+
+    collectSplit(&root, SPLIT_DEPTH, tasks.games, &tasks.count, &nodes);
+
+    runThreads(threads, runPerftWorker, &tasks, 0);
+
+    result->leaves = atomic_load(&tasks.leaves);
+    result->nodes = nodes + atomic_load(&tasks.nodes);
+    result->seconds = getTime() - start;
+
+    free(tasks.games);
+    return 1;
+}
+
+/**
+ * @brief Count the distinct positions reached after exactly `depth` plies
+ *
+ * The positions are expanded one ply at a time and duplicates reached by
+ * different move orders are dropped after every ply. Positions where the
+ * last move won are counted but not expanded. Two players only.
+ *
+ * @param game The game to start from, nobody may have won yet
+ * @param depth Plies to play
+ * @param result Distinct positions, moves made and time
+ * @return 1 on success, 0 if memory ran out or the game has more than two players
+ */
+int countUniquePositions(const Game *game, int depth, PerftResult *result) {
+
+    double start = getTime();
+    PositionKey *level = (PositionKey *) malloc(sizeof(PositionKey));
+    size_t count = 1;
+
+    if (level == NULL || NUM_PLAYERS != 2) {
+        free(level);
+        return 0;
+    }
+    level[0] = getPositionKey(game);
+    result->nodes = 0;
+
+    for (int d = 0; d < depth; d++) {
+        PositionKey *next = (PositionKey *) malloc((count * geometry.columns + 1) * sizeof(PositionKey));
+        size_t size = 0;
+
+        // Check for failed allocation
+        if (next == NULL) {
+            free(level);
+            return 0;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            Game current;
+            loadGameFromKey(&current, level[i]);
+
+            // The previous move ended the game
+            if (current.moves > game->moves &&
+                hasConnect(current.disks[(current.moves + 1) % NUM_PLAYERS], geometry.connect)) {
+                continue;
+            }
+
+            for (int col = 0; col < geometry.columns; col++) {
+                if (canPlay(&current, col)) {
+                    gameMakeMove(&current, col);
+                    next[size++] = getPositionKey(&current);
+                    gameUnmakeMove(&current);
+                    result->nodes++;
+                }
+            }
+        }
+
+        // Drop the duplicates
+        qsort(next, size, sizeof(PositionKey), compareKeys);
+        count = 0;
+        for (size_t i = 0; i < size; i++) {
+            if (count == 0 || next[count - 1] != next[i]) {
+                next[count++] = next[i];
+            }
+        }
+
+        free(level);
+        level = next;
+    }
+
+    free(level);
+    result->leaves = count;
+    result->seconds = getTime() - start;
+    return 1;
+}
@@ -0,0 +1,30 @@
+/**
+ * @file perft.h
+ * @brief Header file for perft.c
+ *
+ * Perft counts every legal continuation of a position to a fixed depth.
+ * A move that wins ends its line: it counts as a leaf if it is the last
+ * ply, and nothing is played after it otherwise. The counts are fixed for a
+ * given position and depth, so they check move generation and win detection,
+ * and the run time measures their throughput.
+ */
+#ifndef PERFT_H
+#define PERFT_H
+
+#include "game.h"
+
+#define PERFT_GAME 0   // Search on the Game bitboards (gameMakeMove / gameUnmakeMove)
+#define PERFT_BOARD 1  // Search on the character board (makeMove / checkLastMove / undoMove)
+
+typedef struct PerftResult {
+    unsigned long long leaves; // Continuations of exactly `depth` plies, or unique positions
+    unsigned long long nodes;  // Moves made
+    double seconds;            // Wall-clock time
+} PerftResult;
+
+unsigned long long perftGame(Game *game, int depth, unsigned long long *nodes);
+unsigned long long perftBoard(char board[MAX_ROWS][MAX_COLS], int moves, int depth, unsigned long long *nodes);
+int runPerftSearch(const Game *game, int depth, int threads, int backend, PerftResult *result);
+int countUniquePositions(const Game *game, int depth, PerftResult *result);
+
+#endif
@@ -0,0 +1,360 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "record.h"
+#include "bulkValidator.h"
+#include "codec.h"
+
+/**
+ * @brief Get the number of bytes of a record for the current geometry
+ * @return The smallest number of bytes that holds BB_SIZE bits
+ */
+int getRecordSize(void) {
+    return (BB_SIZE + 7) / 8;
+}
+
+/**
+ * @brief Write a position key as a record
+ *
+ * @param key The position key
+ * @param record Buffer of at least `getRecordSize()` bytes
+ */
+void storeRecord(PositionKey key, unsigned char *record) {
+
+    int size = getRecordSize();
+
+    // Lowest byte first, whatever the byte order of the machine
+    for (int i = 0; i < size; i++) {
+        record[i] = (unsigned char) (key >> (8 * i));
+    }
+}
+
+/**
+ * @brief Read the position key of a record
+ *
+ * @param record The record
+ * @return The position key, checked only by `keyToBoard`
+ */
+PositionKey loadRecord(const unsigned char *record) {
+
+    PositionKey key = 0;
+
+    for (int i = getRecordSize() - 1; i >= 0; i--) {
+        key = (key << 8) | record[i];
+    }
+
+    return key;
+}
+
+/**
+ * @brief Get the position key of a two-player board
+ *
+ * Goes through `loadGame` and `getPositionKey`, so the records always use
+ * the key layout of game.c.
+ *
+ * @param board The 2D board array, in the current geometry
+ * @param key The position key
+ * @return VALID_BOARD on success, INVALID_BOARD if a disk floats or a cell holds another character
+ */
+int boardToKey(const char board[MAX_ROWS][MAX_COLS], PositionKey *key) {
+
+    Game game;
+
+    if (!loadGame(&game, board, geometry.rows, geometry.columns)) {
+        return INVALID_BOARD;
+    }
+
+    *key = getPositionKey(&game);
+    return VALID_BOARD;
+}
+
+/**
+ * @brief Fill a board from a position key
+ *
+ * Goes through `loadGameFromKey` and `storeGame`, the inverse of
+ * `boardToKey`.
+ *
+ * @param key The position key
+ * @param board The 2D board array to fill, in the current geometry
+ * @return VALID_BOARD on success, INVALID_BOARD if the key is malformed
+ */
+int keyToBoard(PositionKey key, char board[MAX_ROWS][MAX_COLS]) {
+
+    Game game;
+
+    if (!loadGameFromKey(&game, key)) {
+        return INVALID_BOARD;
+    }
+
+    storeGame(&game, board);
+    return VALID_BOARD;
+}
+
+/**
+ * @brief Convert an array of boards to records
+ *
+ * @param boards The boards, in the current geometry
+ * @param count Number of boards
+ * @param records Buffer of at least `count * getRecordSize()` bytes
+ * @return Number of boards converted; less than `count` if board number `return value` cannot be stored
+ */
+size_t encodeRecords(const char boards[][MAX_ROWS][MAX_COLS], size_t count, unsigned char *records) {
+
+    int size = getRecordSize();
+    PositionKey key;
+
+    for (size_t i = 0; i < count; i++) {
+        if (!boardToKey(boards[i], &key)) {
+            return i;
+        }
+        storeRecord(key, records + i * size);
+    }
+
+    return count;
+}
+
+/**
+ * @brief Convert an array of records to boards
+ *
+ * @param records The records, back to back
+ * @param count Number of records
+ * @param boards The boards to fill
+ * @return Number of records converted; less than `count` if record number `return value` is malformed
+ */
+size_t decodeRecords(const unsigned char *records, size_t count, char boards[][MAX_ROWS][MAX_COLS]) {
+
+    int size = getRecordSize();
+
+    for (size_t i = 0; i < count; i++) {
+        if (!keyToBoard(loadRecord(records + i * size), boards[i])) {
+            return i;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief Convert an `encode()` string to a record
+ *
+ * @param code The encoded board, checked before decoding
+ * @param record Buffer of at least `getRecordSize()` bytes
+ * @return VALID_BOARD on success, INVALID_BOARD if the string is not a storable board
+ */
+int codeToRecord(const char *code, unsigned char *record) {
+
+    char board[MAX_ROWS][MAX_COLS];
+    PositionKey key;
+
+    if (!isWellFormedCode(code, geometry.rows, geometry.columns)) {
+        return INVALID_BOARD;
+    }
+
+    decode(code, board);
+    if (!boardToKey(board, &key)) {
+        return INVALID_BOARD;
+    }
+
+    storeRecord(key, record);
+    return VALID_BOARD;
+}
+
+/**
+ * @brief Convert a record to an `encode()` string
+ *
+ * @param record The record
+ * @param code Buffer of at least 2 * rows * columns + rows + 1 characters
+ * @return VALID_BOARD on success, INVALID_BOARD if the record is malformed
+ */
+int recordToCode(const unsigned char *record, char *code) {
+
+    char board[MAX_ROWS][MAX_COLS];
+
+    if (!keyToBoard(loadRecord(record), board)) {
+        return INVALID_BOARD;
+    }
+
+    encode(board, geometry.rows, geometry.columns, code);
+    return VALID_BOARD;
+}
+
+/**
+ * @brief Write the archive header
+ *
+ * @param output The archive file
+ * @param count Number of records
+ * @return 1 on success, 0 if the write failed
+ */
+static int writeHeader(FILE *output, uint64_t count) {
+
+    ArchiveHeader header;
+    memcpy(header.magic, ARCHIVE_MAGIC, 4);
+    header.version = ARCHIVE_VERSION;
+    header.rows = geometry.rows;
+    header.columns = geometry.columns;
+    header.connect = geometry.connect;
+    header.recordSize = getRecordSize();
+    header.count = count;
+
+    return fwrite(&header, sizeof(header), 1, output) == 1;
+}
+
+/**
+ * @brief Pack a stream of encoded boards, one per line, into an archive
+ *
+ * The header is written first with no records and rewritten at the end,
+ * so the output must be a seekable file.
+ *
+ * @param input The encoded boards
+ * @param output The archive file, opened for binary writing
+ * @param count Number of records written, the failing line is `count + 1`
+ * @return 1 on success, 0 if a line is not a storable board or a write failed
+ */
+int packCodes(FILE *input, FILE *output, uint64_t *count) {
+
+    unsigned char records[RECORD_BATCH * RECORD_MAX_BYTES];
+    char line[MAX_CODE_LENGTH + 2];
+    int size = getRecordSize();
+    int batch = 0;
+
+    *count = 0;
+    if (!writeHeader(output, 0)) {
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), input) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+
+        if (!codeToRecord(line, records + batch * size)) {
+            *count += batch;
+            return 0;
+        }
+        batch++;
+
+        // Write full batches as they come
+        if (batch == RECORD_BATCH) {
+            if (fwrite(records, size, batch, output) != (size_t) batch) {
+                return 0;
+            }
+            *count += batch;
+            batch = 0;
+        }
+    }
+
+    if (fwrite(records, size, batch, output) != (size_t) batch) {
+        return 0;
+    }
+    *count += batch;
+
+    // Store the final record count
+    return fseek(output, 0, SEEK_SET) == 0 && writeHeader(output, *count) && fflush(output) == 0;
+}
+
+/**
+ * @brief Map an archive file into memory
+ *
+ * Only the header is checked; the records are used in place. An archive
+ * must match the current geometry.
+ *
+ * @param path Path of the archive file
+ * @return The archive, or NULL if the file cannot be used with this board geometry
+ */
+RecordArchive * openArchive(const char *path) {
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(ArchiveHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // The mapping stays valid without the descriptor
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    const ArchiveHeader *header = (const ArchiveHeader *) map;
+    size_t room = ((size_t) info.st_size - sizeof(ArchiveHeader)) / getRecordSize();
+
+    // Reject archives of another format or board geometry; the count is
+    // bounded by the file before it is multiplied, so it cannot overflow
+    if (memcmp(header->magic, ARCHIVE_MAGIC, 4) != 0 || header->version != ARCHIVE_VERSION ||
+        header->rows != geometry.rows || header->columns != geometry.columns || header->connect != geometry.connect ||
+        header->recordSize != getRecordSize() || header->count > room ||
+        (size_t) info.st_size != sizeof(ArchiveHeader) + header->count * getRecordSize()) {
+        munmap(map, (size_t) info.st_size);
+        return NULL;
+    }
+
+    RecordArchive *archive = (RecordArchive *) malloc(sizeof(RecordArchive));
+    if (archive == NULL) {
+        munmap(map, (size_t) info.st_size);
+        return NULL;
+    }
+
+    // The records are read front to back
+    posix_madvise(map, (size_t) info.st_size, POSIX_MADV_SEQUENTIAL);
+
+    archive->map = map;
+    archive->size = (size_t) info.st_size;
+    archive->recordSize = header->recordSize;
+    archive->count = header->count;
+    archive->records = (const unsigned char *) map + sizeof(ArchiveHeader);
+
+    return archive;
+}
+
+/**
+ * @brief Unmap and free an archive
+ * @param archive The archive, may be NULL
+ */
+void closeArchive(RecordArchive *archive) {
+
+    if (archive == NULL) {
+        return;
+    }
+
+    munmap(archive->map, archive->size);
+    free(archive);
+}
+
+/**
+ * @brief Write every record of an archive as an encoded board, one per line
+ *
+ * @param archive The archive
+ * @param output The stream to write to
+ * @return 1 on success, 0 if a record is malformed or memory ran out
+ */
+int unpackArchive(const RecordArchive *archive, FILE *output) {
+
+    char (*boards)[MAX_ROWS][MAX_COLS] = malloc(RECORD_BATCH * sizeof(*boards));
+    char (*codes)[CODE_SIZE] = malloc(RECORD_BATCH * sizeof(*codes));
+    int ok = boards != NULL && codes != NULL;
+
+    for (uint64_t first = 0; ok && first < archive->count; first += RECORD_BATCH) {
+        size_t batch = archive->count - first < RECORD_BATCH ? archive->count - first : RECORD_BATCH;
+
+        // Convert a whole batch, then print it
+        ok = decodeRecords(archive->records + first * archive->recordSize, batch, boards) == batch;
+        if (ok) {
+            encodeBoards((const char (*)[MAX_ROWS][MAX_COLS]) boards, batch, geometry.rows, geometry.columns, codes);
+        }
+        for (size_t i = 0; ok && i < batch; i++) {
+            fputs(codes[i], output);
+            fputc('\n', output);
+        }
+    }
+
+    free(boards);
+    free(codes);
+    return ok;
+}
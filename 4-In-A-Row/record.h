@@ -0,0 +1,56 @@
+/**
+ * @file record.h
+ * @brief Header file for record.c
+ *
+ * A position record is the position key of a two-player board stored in a
+ * fixed number of little-endian bytes: the smallest number of bytes that
+ * holds BB_SIZE bits (7 bytes on the 7x6 board). Every column holds its
+ * disks bottom first (1 for 'A', 0 for 'B') and a marker bit right above
+ * its top disk, so any board without floating disks converts to a record
+ * and back without loss. An archive is a fixed header followed by the
+ * records back to back, and is used straight from a read-only mapping.
+ */
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <stddef.h>
+#include "game.h"
+
+#define ARCHIVE_MAGIC "C4PK"
+#define ARCHIVE_VERSION 1
+#define RECORD_MAX_BYTES (BITBOARD_BITS / 8) // Size of the widest record
+#define RECORD_BATCH 4096                    // Records converted per batch when packing or unpacking
+
+typedef struct ArchiveHeader {
+    char magic[4];       // ARCHIVE_MAGIC
+    uint32_t version;    // ARCHIVE_VERSION
+    int32_t rows;        // Board geometry the records were made for
+    int32_t columns;
+    int32_t connect;
+    int32_t recordSize;  // Bytes per record
+    uint64_t count;      // Number of records
+} ArchiveHeader;
+
+typedef struct RecordArchive {
+    void *map;                     // The whole mapped file
+    size_t size;                   // Size of the mapping in bytes
+    int recordSize;                // Bytes per record
+    uint64_t count;                // Number of records
+    const unsigned char *records;  // The records, back to back
+} RecordArchive;
+
+int getRecordSize(void);
+void storeRecord(PositionKey key, unsigned char *record);
+PositionKey loadRecord(const unsigned char *record);
+int boardToKey(const char board[MAX_ROWS][MAX_COLS], PositionKey *key);
+int keyToBoard(PositionKey key, char board[MAX_ROWS][MAX_COLS]);
+size_t encodeRecords(const char boards[][MAX_ROWS][MAX_COLS], size_t count, unsigned char *records);
+size_t decodeRecords(const unsigned char *records, size_t count, char boards[][MAX_ROWS][MAX_COLS]);
+int codeToRecord(const char *code, unsigned char *record);
+int recordToCode(const unsigned char *record, char *code);
+int packCodes(FILE *input, FILE *output, uint64_t *count);
+RecordArchive * openArchive(const char *path);
+void closeArchive(RecordArchive *archive);
+int unpackArchive(const RecordArchive *archive, FILE *output);
+
+#endif
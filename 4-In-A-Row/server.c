@@ -0,0 +1,848 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include "server.h"
+#include "solver.h"
+#include "codec.h"
+
+#define NO_SESSION -1
+#define NO_CONNECTION -1
+
+typedef struct Session {
+    Game game;
+    Engine engine;            // Engine answering the client's moves
+    int hasEngine;            // Set if the session has an engine
+    int status;               // GAME_ON, GAME_WON or GAME_TIE
+    int busy;                 // Set while the engine's reply is computed
+    int owner;                // Descriptor of the owning connection, -1 for a free slot
+    unsigned ownerGeneration; // Generation of the owning connection
+    unsigned generation;      // Incremented whenever the slot is freed
+    uint64_t random;          // Seed of the next engine move
+    int prevOwned;            // Neighbours in the owner's list of sessions
+    int nextOwned;
+    int nextFree;             // Next slot of the free list
+} Session;
+
+typedef struct Connection {
+    int open;                      // Set while the descriptor is a client
+    unsigned generation;           // Incremented whenever the descriptor is closed
+    char in[SERVER_LINE_LENGTH];   // The incomplete line read so far
+    int inLength;
+    int discarding;                // Set while skipping the rest of an overlong line
+    char *out;                     // Reply bytes not sent yet
+    size_t outLength;
+    size_t outCapacity;
+    int writing;                   // Set while waiting for the socket to take more bytes
+    int firstSession;              // First session owned by the connection
+    int pending;                   // Set while the connection is in the list of engine replies to send
+    int nextPending;               // Next connection of that list
+} Connection;
+
+typedef struct EngineJob {
+    struct EngineJob *next;
+    int session;              // Session index and generation it was made for
+    unsigned generation;
+    Game game;                // Copy of the position to answer
+    Engine engine;
+    uint64_t seed;
+    int move;                 // The engine's column, filled by the worker
+} EngineJob;
+
+typedef struct Server {
+    int epoll;
+    int listener;
+    int wakeup;                   // eventfd signalled when engine jobs are done
+    Session *sessions;            // The session table, indexed by session id
+    int sessionCount;             // Slots ever used
+    int sessionCapacity;
+    int freeSession;              // Head of the free list
+    Connection *connections;      // Indexed by descriptor
+    int connectionCapacity;
+    int firstPending;             // First connection with engine replies to send
+    pthread_mutex_t lock;         // Guards the job queues and `quit`
+    pthread_cond_t work;          // Signalled when a job is queued
+    EngineJob *jobs;              // Jobs waiting for a worker, oldest first
+    EngineJob *lastJob;
+    EngineJob *done;              // Jobs finished by the workers
+    int quit;                     // Set to stop the workers
+} Server;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+/**
+ * @brief Ask the event loop to stop
+ * @param signal The signal received
+ */
+static void requestStop(int signal) {
+    (void) signal;
+    stopRequested = 1;
+}
+
+/**
+ * @brief Queue a reply line for a connection
+ *
+ * @param conn The connection
+ * @param format printf-style format of the line, without the line break
+ */
+static void reply(Connection *conn, const char *format, ...) {
+
+    char line[SERVER_LINE_LENGTH + CODE_SIZE];
+    va_list args;
+
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line) - 1, format, args);
+    va_end(args);
+
+    if (length < 0) {
+        return;
+    }
+    if (length > (int) sizeof(line) - 2) {
+        length = (int) sizeof(line) - 2;
+    }
+    line[length++] = '\n';
+
+    // Grow the buffer; a client that stops reading is dropped at SERVER_MAX_OUTPUT
+    if (conn->outLength + length > conn->outCapacity) {
+        size_t capacity = conn->outCapacity ? conn->outCapacity * 2 : sizeof(line);
+        while (capacity < conn->outLength + length) {
+            capacity *= 2;
+        }
+
+        char *out = realloc(conn->out, capacity);
+        if (out == NULL) {
+            return;
+        }
+        conn->out = out;
+        conn->outCapacity = capacity;
+    }
+
+    memcpy(conn->out + conn->outLength, line, length);
+    conn->outLength += length;
+}
+
+/**
+ * @brief Describe the state of a session's game
+ *
+ * @param session The session
+ * @param text Buffer of at least 8 characters
+ * @return The buffer
+ */
+static const char * formatState(const Session *session, char *text) {
+
+    if (session->status == GAME_WON) {
+        sprintf(text, "won %c", 'A' + (session->game.moves - 1) % NUM_PLAYERS);
+    } else {
+        strcpy(text, session->status == GAME_TIE ? "tie" : "on");
+    }
+
+    return text;
+}
+
+/**
+ * @brief Create a session owned by a connection
+ *
+ * @param server The server
+ * @param fd Descriptor of the owning connection
+ * @return The session id, NO_SESSION if the table is full
+ */
+static int openSession(Server *server, int fd) {
+
+    int id = server->freeSession;
+
+    if (id != NO_SESSION) {
+        server->freeSession = server->sessions[id].nextFree;
+    } else {
+        // Grow the table when every slot is in use
+        if (server->sessionCount == server->sessionCapacity) {
+            int capacity = server->sessionCapacity * 2;
+            if (capacity > SERVER_MAX_SESSIONS) {
+                return NO_SESSION;
+            }
+
+            Session *sessions = realloc(server->sessions, capacity * sizeof(Session));
+            if (sessions == NULL) {
+                return NO_SESSION;
+            }
+            server->sessions = sessions;
+            server->sessionCapacity = capacity;
+        }
+        id = server->sessionCount++;
+        server->sessions[id].generation = 0;
+    }
+
+    Connection *conn = &server->connections[fd];
+    Session *session = &server->sessions[id];
+
+    initGame(&session->game);
+    session->hasEngine = 0;
+    session->status = GAME_ON;
+    session->busy = 0;
+    session->owner = fd;
+    session->ownerGeneration = conn->generation;
+    session->random = 0x9E3779B97F4A7C15ULL * (uint64_t) (id + 1) ^ session->generation;
+
+    // Link the session into its owner's list
+    session->prevOwned = NO_SESSION;
+    session->nextOwned = conn->firstSession;
+    if (conn->firstSession != NO_SESSION) {
+        server->sessions[conn->firstSession].prevOwned = id;
+    }
+    conn->firstSession = id;
+
+    return id;
+}
+
+/**
+ * @brief Free a session; a pending engine reply is dropped when it arrives
+ *
+ * @param server The server
+ * @param id The session id
+ */
+static void closeSession(Server *server, int id) {
+
+    Session *session = &server->sessions[id];
+    Connection *conn = &server->connections[session->owner];
+
+    // Unlink the session from its owner's list
+    if (session->prevOwned != NO_SESSION) {
+        server->sessions[session->prevOwned].nextOwned = session->nextOwned;
+    } else {
+        conn->firstSession = session->nextOwned;
+    }
+    if (session->nextOwned != NO_SESSION) {
+        server->sessions[session->nextOwned].prevOwned = session->prevOwned;
+    }
+
+    session->owner = -1;
+    session->generation++;
+    session->nextFree = server->freeSession;
+    server->freeSession = id;
+}
+
+/**
+ * @brief Find a session of a connection
+ *
+ * @param server The server
+ * @param fd Descriptor of the connection
+ * @param id The session id sent by the client
+ * @return The session, NULL if it does not exist or belongs to another connection
+ */
+static Session * findSession(Server *server, int fd, int id) {
+
+    if (id < 0 || id >= server->sessionCount) {
+        return NULL;
+    }
+
+    Session *session = &server->sessions[id];
+    if (session->owner != fd || session->ownerGeneration != server->connections[fd].generation) {
+        return NULL;
+    }
+
+    return session;
+}
+
+/**
+ * @brief Hand a session's position to the engine workers
+ *
+ * @param server The server
+ * @param id The session id
+ * @return 1 on success, 0 if memory ran out
+ */
+static int queueEngineMove(Server *server, int id) {
+
+    Session *session = &server->sessions[id];
+    EngineJob *job = (EngineJob *) malloc(sizeof(EngineJob));
+
+    if (job == NULL) {
+        return 0;
+    }
+
+    session->random = session->random * 6364136223846793005ULL + 1442695040888963407ULL;
+    job->next = NULL;
+    job->session = id;
+    job->generation = session->generation;
+    job->game = session->game;
+    job->engine = session->engine;
+    job->seed = session->random;
+    job->move = NO_MOVE;
+    session->busy = 1;
+
+    pthread_mutex_lock(&server->lock);
+    if (server->lastJob != NULL) {
+        server->lastJob->next = job;
+    } else {
+        server->jobs = job;
+    }
+    server->lastJob = job;
+    pthread_cond_signal(&server->work);
+    pthread_mutex_unlock(&server->lock);
+
+    return 1;
+}
+
+/**
+ * @brief Compute engine moves until the server stops
+ * @param arg The Server
+ * @return NULL
+ */
+static void * runEngineWorker(void *arg) {
+
+    Server *server = (Server *) arg;
+    const uint64_t ONE = 1;
+
+    pthread_mutex_lock(&server->lock);
+    for (;;) {
+        while (!server->quit && server->jobs == NULL) {
+            pthread_cond_wait(&server->work, &server->lock);
+        }
+        if (server->quit) {
+            break;
+        }
+
+        EngineJob *job = server->jobs;
+        server->jobs = job->next;
+        if (server->jobs == NULL) {
+            server->lastJob = NULL;
+        }
+        pthread_mutex_unlock(&server->lock);
+
+        job->move = chooseEngineMove(&job->engine, &job->game, job->seed);
+
+        pthread_mutex_lock(&server->lock);
+        job->next = server->done;
+        server->done = job;
+
+        // Wake the event loop; the counter only has to become non-zero
+        if (write(server->wakeup, &ONE, sizeof(ONE)) < 0) {
+            // The counter is already huge, the loop will wake anyway
+        }
+    }
+    pthread_mutex_unlock(&server->lock);
+
+    return NULL;
+}
+
+/**
+ * @brief Play the engine moves computed by the workers and queue them
+ *
+ * Every connection that gets a reply is listed once, so only those are
+ * flushed afterwards.
+ *
+ * @param server The server
+ */
+static void applyEngineMoves(Server *server) {
+
+    uint64_t count;
+    if (read(server->wakeup, &count, sizeof(count)) < 0) {
+        return; // Spurious wake-up
+    }
+
+    pthread_mutex_lock(&server->lock);
+    EngineJob *job = server->done;
+    server->done = NULL;
+    pthread_mutex_unlock(&server->lock);
+
+    while (job != NULL) {
+        EngineJob *next = job->next;
+        Session *session = &server->sessions[job->session];
+
+        // Sessions closed in the meantime have a new generation
+        if (session->owner >= 0 && session->generation == job->generation && session->busy) {
+            Connection *conn = &server->connections[session->owner];
+            char state[8];
+
+            session->busy = 0;
+            if (job->move != NO_MOVE && canPlay(&session->game, job->move)) {
+                session->status = gamePlay(&session->game, job->move);
+                reply(conn, "reply %d %d %s", job->session, job->move, formatState(session, state));
+            } else {
+                reply(conn, "error %d engine failed", job->session);
+            }
+
+            if (!conn->pending) {
+                conn->pending = 1;
+                conn->nextPending = server->firstPending;
+                server->firstPending = session->owner;
+            }
+        }
+
+        free(job);
+        job = next;
+    }
+}
+
+/**
+ * @brief Run one command line of a client
+ *
+ * @param server The server
+ * @param fd Descriptor of the client
+ * @param line The command, without the line break
+ */
+static void handleCommand(Server *server, int fd, const char *line) {
+
+    Connection *conn = &server->connections[fd];
+    char command[16];
+    char argument[ENGINE_NAME_LENGTH];
+    char state[8];
+    int id;
+    int value;
+
+    int fields = sscanf(line, "%15s %d %d", command, &id, &value);
+    if (fields < 1) {
+        reply(conn, "error - empty command");
+        return;
+    }
+
+    if (strcmp(command, "new") == 0) {
+        const char *WHITESPACE = " \t\v\f\r";
+        Engine engine;
+
+        // The engine is the rest of the line, so an overlong one is seen whole
+        const char *spec = line + strspn(line, WHITESPACE);
+        spec += strcspn(spec, WHITESPACE);
+        spec += strspn(spec, WHITESPACE);
+        size_t length = strlen(spec);
+        while (length > 0 && strchr(WHITESPACE, spec[length - 1]) != NULL) {
+            length--;
+        }
+
+        if (length >= ENGINE_NAME_LENGTH) {
+            reply(conn, "error - engine name too long");
+            return;
+        }
+        memcpy(argument, spec, length);
+        argument[length] = '\0';
+
+        int hasEngine = length > 0;
+        if (hasEngine && !parseEngine(argument, &engine)) {
+            reply(conn, "error - unknown engine");
+            return;
+        }
+
+        id = openSession(server, fd);
+        if (id == NO_SESSION) {
+            reply(conn, "error - too many sessions");
+            return;
+        }
+        server->sessions[id].hasEngine = hasEngine;
+        if (hasEngine) {
+            server->sessions[id].engine = engine;
+        }
+        reply(conn, "ok %d", id);
+        return;
+    }
+
+    Session *session = fields >= 2 ? findSession(server, fd, id) : NULL;
+    if (session == NULL) {
+        reply(conn, "error - unknown session");
+        return;
+    }
+
+    if (strcmp(command, "move") == 0) {
+        if (fields < 3) {
+            reply(conn, "error %d missing column", id);
+        } else if (session->busy) {
+            reply(conn, "error %d busy", id);
+        } else if (session->status != GAME_ON) {
+            reply(conn, "error %d game over", id);
+        } else if (!canPlay(&session->game, value)) {
+            reply(conn, "error %d invalid column", id);
+        } else {
+            session->status = gamePlay(&session->game, value);
+            reply(conn, "ok %d %s", id, formatState(session, state));
+
+            if (session->hasEngine && session->status == GAME_ON && !queueEngineMove(server, id)) {
+                reply(conn, "error %d engine failed", id);
+            }
+        }
+    } else if (strcmp(command, "undo") == 0) {
+        if (session->busy) {
+            reply(conn, "error %d busy", id);
+        } else {
+            int undone = gameUndoMoves(&session->game, fields >= 3 ? value : 1);
+            if (undone > 0) {
+                session->status = GAME_ON;
+            }
+            reply(conn, "ok %d %d", id, undone);
+        }
+    } else if (strcmp(command, "status") == 0) {
+        reply(conn, "ok %d %s", id, formatState(session, state));
+    } else if (strcmp(command, "board") == 0) {
+        char board[MAX_ROWS][MAX_COLS];
+        char code[CODE_SIZE];
+
+        storeGame(&session->game, board);
+        encodeBoard(board, geometry.rows, geometry.columns, code);
+        reply(conn, "ok %d %s", id, code);
+    } else if (strcmp(command, "close") == 0) {
+        closeSession(server, id);
+        reply(conn, "ok %d", id);
+    } else {
+        reply(conn, "error %d unknown command", id);
+    }
+}
+
+/**
+ * @brief Close a client and free its sessions
+ *
+ * @param server The server
+ * @param fd Descriptor of the client
+ */
+static void closeConnection(Server *server, int fd) {
+
+    Connection *conn = &server->connections[fd];
+
+    while (conn->firstSession != NO_SESSION) {
+        closeSession(server, conn->firstSession);
+    }
+
+    epoll_ctl(server->epoll, EPOLL_CTL_DEL, fd, NULL);
+    close(fd);
+    free(conn->out);
+    conn->out = NULL;
+    conn->outLength = 0;
+    conn->outCapacity = 0;
+    conn->open = 0;
+    conn->generation++;
+}
+
+/**
+ * @brief Send as much of a client's pending replies as the socket takes
+ *
+ * Waits for EPOLLOUT while bytes are left.
+ *
+ * @param server The server
+ * @param fd Descriptor of the client
+ * @return 1 if the client is still open, 0 if it was closed
+ */
+static int flushConnection(Server *server, int fd) {
+
+    Connection *conn = &server->connections[fd];
+    size_t sent = 0;
+
+    while (sent < conn->outLength) {
+        ssize_t count = send(fd, conn->out + sent, conn->outLength - sent, MSG_NOSIGNAL);
+
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (count < 0) {
+            closeConnection(server, fd);
+            return 0;
+        }
+        sent += count;
+    }
+
+    memmove(conn->out, conn->out + sent, conn->outLength - sent);
+    conn->outLength -= sent;
+
+    if (conn->outLength > SERVER_MAX_OUTPUT) {
+        closeConnection(server, fd);
+        return 0;
+    }
+
+    // Only ask for EPOLLOUT while there is something left to send
+    int writing = conn->outLength > 0;
+    if (writing != conn->writing) {
+        struct epoll_event event = {0};
+        event.events = EPOLLIN | (writing ? EPOLLOUT : 0);
+        event.data.fd = fd;
+        epoll_ctl(server->epoll, EPOLL_CTL_MOD, fd, &event);
+        conn->writing = writing;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Send the engine replies queued by `applyEngineMoves`
+ * @param server The server
+ */
+static void flushPending(Server *server) {
+
+    while (server->firstPending != NO_CONNECTION) {
+        int fd = server->firstPending;
+        Connection *conn = &server->connections[fd];
+
+        server->firstPending = conn->nextPending;
+        conn->pending = 0;
+        if (conn->open && conn->outLength > 0) {
+            flushConnection(server, fd);
+        }
+    }
+}
+
+/**
+ * @brief Read what a client sent and run every complete line
+ *
+ * Replies are sent as soon as more than SERVER_MAX_OUTPUT bytes wait, and
+ * a client that still does not take them is dropped.
+ *
+ * @param server The server
+ * @param fd Descriptor of the client
+ * @return 1 if the client is still open, 0 if it was closed
+ */
+static int readConnection(Server *server, int fd) {
+
+    char buffer[4096];
+
+    for (;;) {
+        ssize_t count = read(fd, buffer, sizeof(buffer));
+
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return 1;
+        }
+        if (count <= 0) {
+            closeConnection(server, fd);
+            return 0;
+        }
+
+        for (ssize_t i = 0; i < count; i++) {
+            Connection *conn = &server->connections[fd];
+
+            if (buffer[i] != '\n') {
+                // Keep the line if it fits, otherwise skip to its end
+                if (conn->inLength < SERVER_LINE_LENGTH - 1) {
+                    conn->in[conn->inLength++] = buffer[i];
+                } else {
+                    conn->discarding = 1;
+                }
+                continue;
+            }
+
+            if (conn->discarding) {
+                reply(conn, "error - line too long");
+            } else {
+                if (conn->inLength > 0 && conn->in[conn->inLength - 1] == '\r') {
+                    conn->inLength--;
+                }
+                conn->in[conn->inLength] = '\0';
+                handleCommand(server, fd, conn->in);
+            }
+            conn->inLength = 0;
+            conn->discarding = 0;
+
+            // A client that keeps sending without reading is dropped before its replies pile up
+            if (conn->outLength > SERVER_MAX_OUTPUT && !flushConnection(server, fd)) {
+                return 0;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Accept every waiting client
+ * @param server The server
+ */
+static void acceptConnections(Server *server) {
+
+    for (;;) {
+        int fd = accept4(server->listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return; // EAGAIN once the backlog is empty
+        }
+
+        // The connection table is indexed by descriptor
+        if (fd >= server->connectionCapacity) {
+            int capacity = server->connectionCapacity * 2;
+            while (capacity <= fd) {
+                capacity *= 2;
+            }
+
+            Connection *connections = realloc(server->connections, capacity * sizeof(Connection));
+            if (connections == NULL) {
+                close(fd);
+                continue;
+            }
+            memset(connections + server->connectionCapacity, 0,
+                   (capacity - server->connectionCapacity) * sizeof(Connection));
+            server->connections = connections;
+            server->connectionCapacity = capacity;
+        }
+
+        Connection *conn = &server->connections[fd];
+        conn->open = 1;
+        conn->inLength = 0;
+        conn->discarding = 0;
+        conn->writing = 0;
+        conn->firstSession = NO_SESSION;
+        conn->pending = 0;
+
+        struct epoll_event event = {0};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(server->epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            conn->open = 0;
+            conn->generation++;
+        }
+    }
+}
+
+/**
+ * @brief Open the listening socket, the epoll instance and the wake-up eventfd
+ *
+ * @param server The server
+ * @param path Path of the socket file, replaced if it exists
+ * @return 1 on success, 0 on failure
+ */
+static int openServer(Server *server, const char *path) {
+
+    struct sockaddr_un address = {0};
+    struct epoll_event event = {0};
+
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        return 0;
+    }
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    unlink(path);
+
+    server->listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    server->epoll = epoll_create1(EPOLL_CLOEXEC);
+    server->wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (server->listener < 0 || server->epoll < 0 || server->wakeup < 0 ||
+        bind(server->listener, (struct sockaddr *) &address, sizeof(address)) != 0 ||
+        listen(server->listener, SOMAXCONN) != 0) {
+        return 0;
+    }
+
+    event.events = EPOLLIN;
+    event.data.fd = server->listener;
+    if (epoll_ctl(server->epoll, EPOLL_CTL_ADD, server->listener, &event) != 0) {
+        return 0;
+    }
+    event.data.fd = server->wakeup;
+    return epoll_ctl(server->epoll, EPOLL_CTL_ADD, server->wakeup, &event) == 0;
+}
+
+/**
+ * @brief Serve games on a Unix domain socket until SIGINT or SIGTERM
+ *
+ * @param path Path of the socket file
+ * @param workers Number of threads computing engine replies
+ * @return 1 after a clean stop, 0 if the server could not start (also if no worker thread started)
+ */
+int runServer(const char *path, int workers) {
+
+    const int INITIAL_CAPACITY = 1024;
+    pthread_t threads[MAX_THREADS];
+    struct epoll_event events[SERVER_EVENTS];
+    struct sigaction action = {0};
+    Server server = {0};
+    int started = 0;
+    int ok;
+
+    server.sessions = (Session *) malloc(INITIAL_CAPACITY * sizeof(Session));
+    server.sessionCapacity = INITIAL_CAPACITY;
+    server.freeSession = NO_SESSION;
+    server.connections = (Connection *) calloc(INITIAL_CAPACITY, sizeof(Connection));
+    server.connectionCapacity = INITIAL_CAPACITY;
+    server.firstPending = NO_CONNECTION;
+    server.listener = server.epoll = server.wakeup = -1;
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.work, NULL);
+
+    ok = server.sessions != NULL && server.connections != NULL && openServer(&server, path);
+
+    if (workers > MAX_THREADS) {
+        workers = MAX_THREADS;
+    }
+    for (; ok && started < workers; started++) {
+        if (pthread_create(&threads[started], NULL, runEngineWorker, &server) != 0) {
+            break; // Carry on with the threads we have
+        }
+    }
+    // Engine moves are only computed on the workers, so at least one must run
+    ok = ok && started > 0;
+
+    // Stop on SIGINT or SIGTERM; without SA_RESTART they interrupt epoll_wait
+    stopRequested = 0;
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    while (ok && !stopRequested) {
+        int count = epoll_wait(server.epoll, events, SERVER_EVENTS, -1);
+
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+
+            if (fd == server.listener) {
+                acceptConnections(&server);
+                continue;
+            }
+            if (fd == server.wakeup) {
+                applyEngineMoves(&server);
+                flushPending(&server);
+                continue;
+            }
+            if (!server.connections[fd].open) {
+                continue; // Closed earlier in this batch
+            }
+
+            if ((events[i].events & EPOLLIN) && !readConnection(&server, fd)) {
+                continue;
+            }
+            if (events[i].events & (EPOLLERR | EPOLLHUP) && !(events[i].events & EPOLLIN)) {
+                closeConnection(&server, fd);
+                continue;
+            }
+            flushConnection(&server, fd);
+        }
+    }
+
+    // Stop the workers, then release everything
+    pthread_mutex_lock(&server.lock);
+    server.quit = 1;
+    pthread_cond_broadcast(&server.work);
+    pthread_mutex_unlock(&server.lock);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (int fd = 0; server.connections != NULL && fd < server.connectionCapacity; fd++) {
+        if (server.connections[fd].open) {
+            closeConnection(&server, fd);
+        }
+    }
+    for (EngineJob *lists[2] = {server.jobs, server.done}, **list = lists; list < lists + 2; list++) {
+        while (*list != NULL) {
+            EngineJob *next = (*list)->next;
+            free(*list);
+            *list = next;
+        }
+    }
+
+    if (server.listener >= 0) {
+        close(server.listener);
+        unlink(path);
+    }
+    if (server.epoll >= 0) {
+        close(server.epoll);
+    }
+    if (server.wakeup >= 0) {
+        close(server.wakeup);
+    }
+    pthread_mutex_destroy(&server.lock);
+    pthread_cond_destroy(&server.work);
+    free(server.sessions);
+    free(server.connections);
+
+    return ok;
+}
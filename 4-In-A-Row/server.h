@@ -0,0 +1,37 @@
+/**
+ * @file server.h
+ * @brief Header file for server.c
+ *
+ * Hosts many games at once behind a Unix domain socket. One thread runs an
+ * epoll loop over the listening socket and every client connection, and
+ * owns the session table; only engine replies are computed on worker
+ * threads, on a copy of the game, and handed back through an eventfd.
+ *
+ * Clients send one command per line and get one line back per command.
+ * Every reply names the session it is about, so engine replies can arrive
+ * later without confusing the client. Columns are 0-based.
+ *   new [engine]        ok <id>               Create a game; with an engine ("random",
+ *                                             "mcts:<budget>") the server answers every move
+ *   move <id> <column>  ok <id> <state>       Play the next player's disk, then maybe
+ *                       reply <id> <column> <state>   later, the engine's move
+ *   undo <id> [count]   ok <id> <undone>      Take back moves (default 1)
+ *   status <id>         ok <id> <state>       <state> is "on", "won <player>" or "tie"
+ *   board <id>          ok <id> <code>        The board in the `encode()` format
+ *   close <id>          ok <id>               Free the session
+ * Failures are answered with "error <id> <reason>" ("error - <reason>" when
+ * no session applies). Sessions belong to the connection that created them
+ * and are freed when it disconnects.
+ */
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "tournament.h"
+
+#define SERVER_LINE_LENGTH 256           // Longest command line, longer ones are rejected
+#define SERVER_MAX_OUTPUT (1 << 20)      // Unsent reply bytes allowed before a client is dropped
+#define SERVER_MAX_SESSIONS (1 << 20)    // Sessions open at once, all clients
+#define SERVER_EVENTS 256                // Events handled per epoll_wait call
+
+int runServer(const char *path, int workers);
+
+#endif
@@ -0,0 +1,984 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <pthread.h>
+#include "solver.h"
+#include "bulkValidator.h"
+#include "instrument.h"
+
+/**
+ * @brief Get a monotonic wall-clock time
+ * @return The current time in seconds
+ */
+double getTime(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Allocate a solver with an empty transposition table
+ * @return The new solver, or NULL if the allocation failed
+ */
+Solver * makeSolver(void) {
+
+    Solver *solver = (Solver *) malloc(sizeof(Solver));
+    if (solver == NULL) {
+        return NULL;
+    }
+
+    solver->table = (TableEntry *) calloc(TT_SIZE, sizeof(TableEntry));
+    solver->searchTable = (TableEntry *) calloc(SEARCH_TT_SIZE, sizeof(TableEntry));
+    solver->book = NULL;
+    solver->tablebase = NULL;
+    solver->threads = 1;
+    solver->nodes = 0;
+    solver->deadline = 0;
+    atomic_init(&solver->stop, 0);
+    atomic_init(&solver->done, 0);
+    atomic_init(&solver->searchNodes, 0);
+
+    // Check for failed allocation
+    if (solver->table == NULL || solver->searchTable == NULL) {
+        freeSolver(solver);
+        return NULL;
+    }
+
+    return solver;
+}
+
+/**
+ * @brief Free a solver and its transposition table
+ * @param solver The solver to free, may be NULL
+ */
+void freeSolver(Solver *solver) {
+
+    if (solver == NULL) {
+        return;
+    }
+
+    free(solver->table);
+    free(solver->searchTable);
+    free(solver);
+}
+
+/**
+ * @brief Forget everything stored in the transposition tables
+ * @param solver The solver to reset
+ */
+void resetSolver(Solver *solver) {
+    memset(solver->table, 0, TT_SIZE * sizeof(TableEntry));
+    memset(solver->searchTable, 0, SEARCH_TT_SIZE * sizeof(TableEntry));
+}
+
+/**
+ * @brief Set the number of threads used by the next solves
+ * @param solver The solver
+ * @param threads Number of threads, clamped to 1..MAX_THREADS
+ */
+void setSolverThreads(Solver *solver, int threads) {
+
+    if (threads < 1) {
+        threads = 1;
+    } else if (threads > MAX_THREADS) {
+        threads = MAX_THREADS;
+    }
+
+    solver->threads = threads;
+}
+
+/**
+ * @brief Set the opening book consulted by the next solves
+ * @param solver The solver
+ * @param book The book, or NULL to search every position
+ */
+void setSolverBook(Solver *solver, const OpeningBook *book) {
+    solver->book = book;
+}
+
+/**
+ * @brief Set the tablebase consulted by the next solves
+ * @param solver The solver
+ * @param tablebase The tablebase, or NULL to search every position
+ */
+void setSolverTablebase(Solver *solver, const Tablebase *tablebase) {
+    solver->tablebase = tablebase;
+}
+
+/**
+ * @brief Get the table slot of a game
+ *
+ * The slot comes from the Zobrist hash; the exact position key stored in
+ * the slot tells positions that share a slot apart.
+ *
+ * @param game The game
+ * @return Index into the transposition table
+ */
+static size_t getTableIndex(const Game *game) {
+    return (size_t) (game->hash >> (64 - TT_BITS));
+}
+
+/**
+ * @brief Get the columns in the order they should be searched
+ *
+ * Central columns take part in more lines, so they are tried first.
+ *
+ * @param order Array of one entry per column to fill
+ */
+static void getColumnOrder(int order[MAX_COLS]) {
+    for (int i = 0; i < geometry.columns; i++) {
+        order[i] = geometry.columns / 2 + (1 - 2 * (i % 2)) * (i + 1) / 2;
+    }
+}
+
+/**
+ * @brief Get the moves that do not hand the opponent an immediate win
+ *
+ * If the opponent threatens to win in a playable cell, that cell is the only
+ * move left; two such threats lose. A cell right below an opponent's winning
+ * cell is never played either.
+ *
+ * @param game The game, the player to move must not be able to win at once
+ * @return A bitboard of the cells that can be played, 0 if every move loses
+ */
+static Bitboard getNonLosingMoves(const Game *game) {
+
+    int opponent = (game->moves + 1) % NUM_PLAYERS;
+    Bitboard possible = (game->mask + BB_BOTTOM_MASK) & BB_BOARD_MASK;
+    Bitboard threats = getWinningCells(game->disks[opponent], game->mask, geometry.connect);
+    Bitboard forced = possible & threats;
+
+    if (forced) {
+        // More than one cell must be blocked at once
+        if (forced & (forced - 1)) {
+            return 0;
+        }
+        possible = forced;
+    }
+
+    return possible & ~(threats >> 1);
+}
+
+/**
+ * @brief Check if the player to move can win with their next disk
+ * @param game The game
+ * @return 1 if a winning move exists, 0 otherwise
+ */
+static int canWinNext(const Game *game) {
+    Bitboard possible = (game->mask + BB_BOTTOM_MASK) & BB_BOARD_MASK;
+    return (getWinningCells(game->disks[getCurrentPlayer(game)], game->mask, geometry.connect) & possible) != 0;
+}
+
+/**
+ * @brief Score a move by the number of winning cells it leaves its player
+ * @param game The game before the move
+ * @param move The cell to play
+ * @return Number of cells the player would then threaten
+ */
+static int scoreMove(const Game *game, Bitboard move) {
+    Bitboard disks = game->disks[getCurrentPlayer(game)] | move;
+    return BB_COUNT(getWinningCells(disks, game->mask | move, geometry.connect));
+}
+
+/**
+ * @brief Look up the value stored for a position in a table slot
+ *
+ * An entry is only trusted when its check word matches the value it was
+ * written with, so entries torn by a concurrent write are ignored.
+ *
+ * @param entry The table slot of the game
+ * @param key The position key of the game
+ * @return The stored value, 0 if there is none
+ */
+static uint64_t loadEntry(TableEntry *entry, PositionKey key) {
+
+    uint64_t value = atomic_load_explicit(&entry->value, memory_order_relaxed);
+    uint64_t check = atomic_load_explicit(&entry->check, memory_order_relaxed);
+
+    return (check ^ value) == FOLD_KEY(key) ? value : 0;
+}
+
+/**
+ * @brief Store the value of a position, replacing the slot's entry
+ * @param entry The table slot of the game
+ * @param key The position key of the game
+ * @param value The value to store, not 0
+ */
+static void storeEntry(TableEntry *entry, PositionKey key, uint64_t value) {
+    atomic_store_explicit(&entry->value, value, memory_order_relaxed);
+    atomic_store_explicit(&entry->check, FOLD_KEY(key) ^ value, memory_order_relaxed);
+}
+
+/**
+ * @brief Get the next tie-breaking number of a helper thread (xorshift64)
+ * @param worker The search thread
+ * @return A pseudo-random number
+ */
+static uint64_t nextTieBreak(SearchWorker *worker) {
+    worker->random ^= worker->random << 13;
+    worker->random ^= worker->random >> 7;
+    worker->random ^= worker->random << 17;
+    return worker->random;
+}
+
+/**
+ * @brief Recursively compute the score of a position with alpha-beta pruning
+ *
+ * The search is a negamax: the score of a position is the negation of its
+ * best child. Upper bounds are kept in the transposition table, and moves
+ * are tried in order of the threats they create, centre first on ties.
+ * Helper threads break ties at random so they explore different subtrees.
+ * Once the solver is stopped the search unwinds without storing anything.
+ *
+ * @param worker The search thread
+ * @param alpha Lower bound of the search window
+ * @param beta Upper bound of the search window
+ * @return The exact score if it is inside the window, otherwise a bound on the side it fell
+ */
+static int negamax(SearchWorker *worker, int alpha, int beta) {
+
+    Game *game = &worker->game;
+    worker->nodes++;
+    PROBE_DEPTH(DEPTH_NEGAMAX, game->moves);
+
+    // Another thread already has the answer
+    if (atomic_load_explicit(&worker->solver->stop, memory_order_relaxed)) {
+        worker->aborted = 1;
+        return 0;
+    }
+
+    // Early positions are answered by the opening book
+    const OpeningBook *book = worker->solver->book;
+    int bookScore;
+    if (book != NULL && lookupBook(book, game, &bookScore)) {
+        return bookScore;
+    }
+
+    // Every position of a small board is answered by the tablebase
+    const Tablebase *tablebase = worker->solver->tablebase;
+    if (tablebase != NULL && lookupTablebase(tablebase, game, &bookScore)) {
+        return bookScore;
+    }
+
+    Bitboard next = getNonLosingMoves(game);
+    if (next == 0) {
+        // Every move lets the opponent win with their next disk
+        return -(geometry.cells - game->moves) / 2;
+    }
+
+    // Nobody can win within the last two moves of the game
+    if (game->moves >= geometry.cells - 2) {
+        return 0;
+    }
+
+    // The opponent cannot win with their next disk, raise the lower bound
+    int min = -(geometry.cells - 2 - game->moves) / 2;
+    if (alpha < min) {
+        alpha = min;
+        if (alpha >= beta) {
+            return alpha;
+        }
+    }
+
+    // We cannot win with our next disk, lower the upper bound
+    int max = (geometry.cells - 1 - game->moves) / 2;
+    PositionKey key = getPositionKey(game);
+    uint64_t value = loadEntry(&worker->solver->table[getTableIndex(game)], key);
+    if (value) {
+        max = (int) value + MIN_SCORE - 1;
+    }
+    if (beta > max) {
+        beta = max;
+        if (alpha >= beta) {
+            return beta;
+        }
+    }
+
+    // Collect the playable columns, best scored first (insertion sort)
+    int order[MAX_COLS];
+    int columns[MAX_COLS];
+    int scores[MAX_COLS];
+    int count = 0;
+    getColumnOrder(order);
+
+    for (int i = 0; i < geometry.columns; i++) {
+        Bitboard move = next & BB_COLUMN_MASK(order[i]);
+        if (!move) {
+            continue;
+        }
+
+        // Threats decide the order; helpers add noise below that precision
+        int score = scoreMove(game, move) * 8;
+        if (worker->id) {
+            score += (int) (nextTieBreak(worker) & 7);
+        }
+
+        int pos = count++;
+        for (; pos > 0 && scores[pos - 1] < score; pos--) {
+            columns[pos] = columns[pos - 1];
+            scores[pos] = scores[pos - 1];
+        }
+        columns[pos] = order[i];
+        scores[pos] = score;
+    }
+
+    // Search the children
+    for (int i = 0; i < count; i++) {
+        gameMakeMove(game, columns[i]);
+        int score = -negamax(worker, -beta, -alpha);
+        gameUnmakeMove(game);
+
+        // The child's score is meaningless once the search was stopped
+        if (worker->aborted) {
+            return 0;
+        }
+
+        // Prune: the opponent will avoid this position
+        if (score >= beta) {
+            return score;
+        }
+        if (score > alpha) {
+            alpha = score;
+        }
+    }
+
+    // Remember the upper bound of this position
+    storeEntry(&worker->solver->table[getTableIndex(game)], key, (uint64_t) (alpha - MIN_SCORE + 1));
+
+    return alpha;
+}
+
+/**
+ * @brief Compute the exact score of a position
+ *
+ * The score is narrowed down with a sequence of null-window searches, which
+ * prune far more than a single search with the full window.
+ *
+ * @param worker The search thread, its game must not be won yet
+ * @return The score for the player to move, meaningless if the worker was aborted
+ */
+static int solvePosition(SearchWorker *worker) {
+
+    Game *game = &worker->game;
+    int bookScore;
+
+    if (canWinNext(game)) {
+        return (geometry.cells + 1 - game->moves) / 2;
+    }
+    if (worker->solver->book != NULL && lookupBook(worker->solver->book, game, &bookScore)) {
+        return bookScore;
+    }
+    if (worker->solver->tablebase != NULL && lookupTablebase(worker->solver->tablebase, game, &bookScore)) {
+        return bookScore;
+    }
+
+    int min = -(geometry.cells - game->moves) / 2;
+    int max = (geometry.cells + 1 - game->moves) / 2;
+
+    while (min < max && !worker->aborted) {
+        // Probe around the middle, but favour windows close to 0
+        int med = min + (max - min) / 2;
+        if (med <= 0 && min / 2 < med) {
+            med = min / 2;
+        } else if (med >= 0 && max / 2 > med) {
+            med = max / 2;
+        }
+
+        int score = negamax(worker, med, med + 1);
+        if (score <= med) {
+            max = score;
+        } else {
+            min = score;
+        }
+    }
+
+    return min;
+}
+
+/**
+ * @brief Run a full solve on one thread and publish it if it finished first
+ *
+ * @param arg The search thread (SearchWorker *)
+ * @return NULL
+ */
+static void * runWorker(void *arg) {
+
+    SearchWorker *worker = (SearchWorker *) arg;
+    Solver *solver = worker->solver;
+    int score = solvePosition(worker);
+    int expected = 0;
+
+    // Only a search that ran to the end knows the exact score
+    if (!worker->aborted && atomic_compare_exchange_strong(&solver->done, &expected, 1)) {
+        solver->score = score;
+        atomic_store(&solver->stop, 1);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Compute the exact score of a position on all solver threads
+ *
+ * @param solver The solver
+ * @param game The game, nobody may have won yet
+ * @return The score for the player to move
+ */
+static int solveParallel(Solver *solver, const Game *game) {
+
+    SearchWorker workers[MAX_THREADS];
+
+    atomic_store(&solver->stop, 0);
+    atomic_store(&solver->done, 0);
+
+    for (int i = 0; i < solver->threads; i++) {
+        workers[i].solver = solver;
+        workers[i].game = *game;
+        workers[i].id = i;
+        workers[i].aborted = 0;
+        workers[i].random = 0x2545F4914F6CDD1DULL * (uint64_t) (i + 1);
+        workers[i].nodes = 0;
+    }
+
+    runThreads(solver->threads, runWorker, workers, sizeof(workers[0]));
+    for (int i = 0; i < solver->threads; i++) {
+        solver->nodes += workers[i].nodes;
+    }
+
+    atomic_store(&solver->stop, 0);
+    return solver->score;
+}
+
+/**
+ * @brief Solve a game: compute its score and a move that achieves it
+ *
+ * @param solver The solver
+ * @param game The game to solve, left unchanged
+ * @param result The score, best column, nodes and time of the solve
+ * @return VALID_BOARD on success, INVALID_BOARD if the game has more than two players
+ */
+int solveGame(Solver *solver, const Game *game, SolveResult *result) {
+
+    if (NUM_PLAYERS != 2) {
+        return INVALID_BOARD;
+    }
+
+    SearchWorker worker = {solver, *game, 0, 0, 0, 0};
+    Game *copy = &worker.game;
+    double start = getTime();
+    solver->nodes = 0;
+    result->bestMove = NO_MOVE;
+
+    if (hasConnect(copy->disks[(copy->moves + 1) % NUM_PLAYERS], geometry.connect)) {
+        // The previous player already won
+        result->score = -(geometry.cells + 2 - copy->moves) / 2;
+    } else if (copy->moves == geometry.cells) {
+        // Full board without a winner
+        result->score = 0;
+    } else {
+        result->score = solveParallel(solver, copy);
+
+        int order[MAX_COLS];
+        getColumnOrder(order);
+
+        // Find a column whose child proves the score
+        for (int i = 0; i < geometry.columns && result->bestMove == NO_MOVE; i++) {
+            int col = order[i];
+            if (!canPlay(copy, col)) {
+                continue;
+            }
+
+            int player = getCurrentPlayer(copy);
+            gameMakeMove(copy, col);
+
+            if (hasConnect(copy->disks[player], geometry.connect)) {
+                // Only the fastest win scores this high
+                if (result->score == (geometry.cells + 2 - copy->moves) / 2) {
+                    result->bestMove = col;
+                }
+            } else if (copy->moves == geometry.cells) {
+                if (result->score == 0) {
+                    result->bestMove = col;
+                }
+            } else if (canWinNext(copy)) {
+                // The opponent wins at once, only fine if every move loses that fast
+                if (result->score == -(geometry.cells + 1 - copy->moves) / 2) {
+                    result->bestMove = col;
+                }
+            } else {
+                // The child is worth at most -score when a null-window probe fails low
+                int bound = -result->score;
+                if (negamax(&worker, bound, bound + 1) <= bound) {
+                    result->bestMove = col;
+                }
+            }
+
+            gameUnmakeMove(copy);
+        }
+    }
+
+    solver->nodes += worker.nodes;
+    result->nodes = solver->nodes;
+    result->seconds = getTime() - start;
+
+    return VALID_BOARD;
+}
+
+/**
+ * @brief Solve a position given as a character board
+ *
+ * @param solver The solver
+ * @param board The 2D board array, must be a valid board
+ * @param result The score, best column, nodes and time of the solve
+ * @return VALID_BOARD on success, INVALID_BOARD if the board is not valid
+ */
+int solveBoard(Solver *solver, const char board[MAX_ROWS][MAX_COLS], SolveResult *result) {
+
+    if (!isValidBoard(board, geometry.rows, geometry.columns, NUM_PLAYERS, geometry.connect)) {
+        return INVALID_BOARD;
+    }
+
+    Game game;
+    if (!loadGame(&game, board, geometry.rows, geometry.columns)) {
+        return INVALID_BOARD;
+    }
+
+    return solveGame(solver, &game, result);
+}
+
+/**
+ * @brief Solve a position given in the `encode()` format
+ *
+ * @param solver The solver
+ * @param code The encoded board
+ * @param result The score, best column, nodes and time of the solve
+ * @return VALID_BOARD on success, INVALID_BOARD if the string or the board is not valid
+ */
+int solveCode(Solver *solver, const char *code, SolveResult *result) {
+
+    char board[MAX_ROWS][MAX_COLS];
+
+    // The string may come from the command line, so check it before decoding
+    if (!isWellFormedCode(code, geometry.rows, geometry.columns)) {
+        return INVALID_BOARD;
+    }
+
+    initBoard(board, geometry.rows, geometry.columns);
+    decode(code, board);
+
+    return solveBoard(solver, board, result);
+}
+
+/**
+ * @brief Estimate a position at the horizon of the anytime search
+ *
+ * Every empty cell that would complete a line is a threat; the player with
+ * more of them is likely better off. Disks in the centre column, which takes
+ * part in the most lines, break ties.
+ *
+ * @param game The game
+ * @return A score for the player to move, strictly between -SEARCH_SCALE and SEARCH_SCALE
+ */
+static int evaluatePosition(const Game *game) {
+
+    int player = getCurrentPlayer(game);
+    int opponent = (player + 1) % NUM_PLAYERS;
+    Bitboard centre = BB_COLUMN_MASK(geometry.columns / 2);
+
+    int threats = BB_COUNT(getWinningCells(game->disks[player], game->mask, geometry.connect)) -
+                  BB_COUNT(getWinningCells(game->disks[opponent], game->mask, geometry.connect));
+    int score = threats * 8 + BB_COUNT(game->disks[player] & centre) - BB_COUNT(game->disks[opponent] & centre);
+
+    if (score >= SEARCH_SCALE) {
+        return SEARCH_SCALE - 1;
+    }
+    if (score <= -SEARCH_SCALE) {
+        return -SEARCH_SCALE + 1;
+    }
+    return score;
+}
+
+/**
+ * @brief Search a position to a fixed depth with alpha-beta pruning
+ *
+ * The same negamax as the exact solve, but positions `depth` plies below
+ * the root are estimated instead of searched. Exact results still count
+ * SEARCH_SCALE per point, so a proven win or loss is never mistaken for
+ * an estimate. Results are kept in the search table with their depth and
+ * the best move, which is tried first when the position comes back in the
+ * next iteration. Every SEARCH_CLOCK_INTERVAL nodes the thread publishes its
+ * node count and checks the deadline, and stops every thread once it passed.
+ *
+ * @param worker The search thread
+ * @param depth Plies left to search
+ * @param alpha Lower bound of the search window
+ * @param beta Upper bound of the search window
+ * @param bestMove Set to the best column unless the search was stopped, may be NULL
+ * @return The anytime score, or a bound on the side of the window it fell
+ */
+static int searchDepth(SearchWorker *worker, int depth, int alpha, int beta, int *bestMove) {
+
+    Game *game = &worker->game;
+    Solver *solver = worker->solver;
+
+    PROBE_DEPTH(DEPTH_SEARCH, game->moves);
+    if (++worker->nodes % SEARCH_CLOCK_INTERVAL == 0) {
+        atomic_fetch_add_explicit(&solver->searchNodes, SEARCH_CLOCK_INTERVAL, memory_order_relaxed);
+        if (getTime() >= solver->deadline) {
+            atomic_store(&solver->stop, 1);
+        }
+    }
+    if (atomic_load_explicit(&solver->stop, memory_order_relaxed)) {
+        worker->aborted = 1;
+        return 0;
+    }
+
+    // Solved positions are exact whatever the depth, but the root needs a move
+    int bookScore;
+    if (bestMove == NULL && solver->book != NULL && lookupBook(solver->book, game, &bookScore)) {
+        return bookScore * SEARCH_SCALE;
+    }
+    if (bestMove == NULL && solver->tablebase != NULL && lookupTablebase(solver->tablebase, game, &bookScore)) {
+        return bookScore * SEARCH_SCALE;
+    }
+
+    Bitboard next = getNonLosingMoves(game);
+    if (next == 0) {
+        return -(geometry.cells - game->moves) / 2 * SEARCH_SCALE;
+    }
+    if (game->moves >= geometry.cells - 2) {
+        return 0;
+    }
+
+    // The exact bounds of the solver hold at any depth
+    int min = -(geometry.cells - 2 - game->moves) / 2 * SEARCH_SCALE;
+    int max = (geometry.cells - 1 - game->moves) / 2 * SEARCH_SCALE;
+    if (min >= beta) {
+        return min;
+    }
+    if (max <= alpha) {
+        return max;
+    }
+
+    if (depth == 0) {
+        return evaluatePosition(game);
+    }
+
+    // Reuse a result at least as deep, otherwise only its move
+    PositionKey key = getPositionKey(game);
+    TableEntry *entry = &solver->searchTable[game->hash >> (64 - SEARCH_TT_BITS)];
+    uint64_t value = loadEntry(entry, key);
+    int hashMove = NO_MOVE;
+
+    if (value) {
+        int entryScore = (int) (value & 0xFFFF) - 0x8000;
+        int bound = (int) (value >> 20) & 3;
+
+        hashMove = (int) (value >> 16 & 0xF) - 1;
+        if ((int) (value >> 24) >= depth && bestMove == NULL &&
+            (bound == BOUND_EXACT || (bound == BOUND_LOWER && entryScore >= beta) ||
+             (bound == BOUND_UPPER && entryScore <= alpha))) {
+            return entryScore;
+        }
+    }
+
+    // Collect the playable columns, the stored move first, then by threats
+    int order[MAX_COLS];
+    int columns[MAX_COLS];
+    int scores[MAX_COLS];
+    int count = 0;
+    getColumnOrder(order);
+
+    for (int i = 0; i < geometry.columns; i++) {
+        Bitboard move = next & BB_COLUMN_MASK(order[i]);
+        if (!move) {
+            continue;
+        }
+
+        int score = order[i] == hashMove ? 1 << 20 : scoreMove(game, move) * 8;
+        if (worker->id) {
+            score += (int) (nextTieBreak(worker) & 7);
+        }
+
+        int pos = count++;
+        for (; pos > 0 && scores[pos - 1] < score; pos--) {
+            columns[pos] = columns[pos - 1];
+            scores[pos] = scores[pos - 1];
+        }
+        columns[pos] = order[i];
+        scores[pos] = score;
+    }
+
+    int best = MIN_SCORE * SEARCH_SCALE - 1;
+    int bestColumn = columns[0];
+    int bound = BOUND_UPPER;
+
+    for (int i = 0; i < count; i++) {
+        gameMakeMove(game, columns[i]);
+        int score = -searchDepth(worker, depth - 1, -beta, -alpha, NULL);
+        gameUnmakeMove(game);
+
+        if (worker->aborted) {
+            return 0;
+        }
+
+        if (score > best) {
+            best = score;
+            bestColumn = columns[i];
+        }
+        if (score >= beta) {
+            bound = BOUND_LOWER;
+            break;
+        }
+        if (score > alpha) {
+            alpha = score;
+            bound = BOUND_EXACT;
+        }
+    }
+
+    storeEntry(entry, key, (uint64_t) depth << 24 | (uint64_t) bound << 20 |
+                           (uint64_t) (bestColumn + 1) << 16 | (uint64_t) (best + 0x8000));
+    if (bestMove != NULL) {
+        *bestMove = bestColumn;
+    }
+
+    return best;
+}
+
+/**
+ * @brief Deepen the search of a helper thread until the search is stopped
+ *
+ * Helpers only fill the search table for the calling thread. Every other
+ * helper starts one ply deeper, so the threads spread over two depths.
+ *
+ * @param arg The search thread (SearchWorker *)
+ * @return NULL
+ */
+static void * runSearchHelper(void *arg) {
+
+    SearchWorker *worker = (SearchWorker *) arg;
+    int remaining = geometry.cells - worker->game.moves;
+
+    for (int depth = 1 + worker->id % 2; depth <= remaining && !worker->aborted; depth++) {
+        searchDepth(worker, depth, MIN_SCORE * SEARCH_SCALE, MAX_SCORE * SEARCH_SCALE, NULL);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Record a completed iteration of the anytime search
+ *
+ * @param result The result of the search
+ * @param depth Plies searched
+ * @param score Anytime score of the best move
+ * @param bestMove Best column
+ * @param nodes Positions visited so far
+ * @param seconds Time since the search started
+ */
+static void addIteration(SearchResult *result, int depth, int score, int bestMove, unsigned long long nodes,
+                         double seconds) {
+
+    SearchIteration *iteration = &result->iterations[result->iterationCount++];
+
+    iteration->depth = depth;
+    iteration->score = score;
+    iteration->bestMove = bestMove;
+    iteration->nodes = nodes;
+    iteration->seconds = seconds;
+
+    result->depth = depth;
+    result->score = score;
+    result->bestMove = bestMove;
+}
+
+/**
+ * @brief Deepen the search of a position until a deadline or a stop
+ *
+ * The calling thread searches one ply deeper per iteration and keeps the
+ * best move of the last iteration that completed; helper threads deepen on
+ * their own and share the search table with it (Lazy SMP). Every thread
+ * checks the clock itself and the first to see the deadline stops them
+ * all, so the search returns within a fraction of a millisecond of it.
+ * Setting the solver's stop flag from another thread ends it the same way.
+ * It also ends early once the score is proven or the game is searched to
+ * its end.
+ *
+ * @param solver The solver, its stop flag must be clear
+ * @param game The game, left unchanged
+ * @param deadline Time to stop at
+ * @param result The best move, every completed iteration, nodes and time
+ * @return VALID_BOARD on success, INVALID_BOARD if the game has more than two players
+ */
+static int searchUntil(Solver *solver, const Game *game, double deadline, SearchResult *result) {
+
+    if (NUM_PLAYERS != 2) {
+        return INVALID_BOARD;
+    }
+
+    SearchWorker workers[MAX_THREADS];
+    pthread_t threads[MAX_THREADS];
+    Game *copy = &workers[0].game;
+    int started = 1;
+    double start = getTime();
+
+    memset(result, 0, sizeof(SearchResult));
+    result->bestMove = NO_MOVE;
+    solver->deadline = deadline;
+    atomic_store(&solver->searchNodes, 0);
+
+    for (int i = 0; i < solver->threads; i++) {
+        workers[i].solver = solver;
+        workers[i].game = *game;
+        workers[i].id = i;
+        workers[i].aborted = 0;
+        workers[i].random = 0x2545F4914F6CDD1DULL * (uint64_t) (i + 1);
+        workers[i].nodes = 0;
+    }
+
+    int remaining = geometry.cells - copy->moves;
+    Bitboard possible = (copy->mask + BB_BOTTOM_MASK) & BB_BOARD_MASK;
+    Bitboard next = getNonLosingMoves(copy);
+    int order[MAX_COLS];
+    getColumnOrder(order);
+
+    if (hasConnect(copy->disks[(copy->moves + 1) % NUM_PLAYERS], geometry.connect) || remaining == 0) {
+        // The game is already over
+    } else if (canWinNext(copy)) {
+        // Take the win, no search needed
+        Bitboard wins = getWinningCells(copy->disks[getCurrentPlayer(copy)], copy->mask, geometry.connect) & possible;
+        for (int i = 0; i < geometry.columns && result->bestMove == NO_MOVE; i++) {
+            if (wins & BB_COLUMN_MASK(order[i])) {
+                addIteration(result, 1, (remaining + 1) / 2 * SEARCH_SCALE, order[i], 0, getTime() - start);
+            }
+        }
+        result->exact = 1;
+    } else {
+        // Every move may lose; until an iteration completes, the first column not losing at once
+        Bitboard candidates = next ? next : possible;
+        for (int i = 0; i < geometry.columns && result->bestMove == NO_MOVE; i++) {
+            if (candidates & BB_COLUMN_MASK(order[i])) {
+                result->bestMove = order[i];
+            }
+        }
+
+        if (next == 0) {
+            addIteration(result, 1, -remaining / 2 * SEARCH_SCALE, result->bestMove, 0, getTime() - start);
+            result->exact = 1;
+        } else {
+            // Start the helpers, then deepen on the calling thread
+            started = startHelpers(threads, solver->threads, runSearchHelper, workers, sizeof(workers[0]));
+
+            for (int depth = 1; depth <= remaining && getTime() < solver->deadline; depth++) {
+                int move = result->bestMove; // Kept when the last plies leave nothing to choose
+                int score = searchDepth(&workers[0], depth, MIN_SCORE * SEARCH_SCALE, MAX_SCORE * SEARCH_SCALE, &move);
+                if (workers[0].aborted) {
+                    break;
+                }
+
+                unsigned long long nodes = atomic_load(&solver->searchNodes) + workers[0].nodes % SEARCH_CLOCK_INTERVAL;
+                addIteration(result, depth, score, move, nodes, getTime() - start);
+
+                // Deeper iterations cannot change a proven score
+                if (score >= SEARCH_SCALE || score <= -SEARCH_SCALE || depth == remaining) {
+                    result->exact = 1;
+                    break;
+                }
+            }
+
+            atomic_store(&solver->stop, 1);
+            joinHelpers(threads, started);
+        }
+    }
+
+    solver->nodes = 0;
+    for (int i = 0; i < started; i++) {
+        solver->nodes += workers[i].nodes;
+    }
+    atomic_store(&solver->stop, 0);
+
+    result->nodes = solver->nodes;
+    result->seconds = getTime() - start;
+    return VALID_BOARD;
+}
+
+/**
+ * @brief Choose a move within a wall-clock budget by iterative deepening
+ *
+ * @param solver The solver, its thread count, book and tablebase are used
+ * @param game The game, left unchanged
+ * @param seconds Time budget of the search
+ * @param result The best move, every completed iteration, nodes and time
+ * @return VALID_BOARD on success, INVALID_BOARD if the game has more than two players
+ */
+int searchDeadline(Solver *solver, const Game *game, double seconds, SearchResult *result) {
+    atomic_store(&solver->stop, 0);
+    return searchUntil(solver, game, getTime() + seconds, result);
+}
+
+/**
+ * @brief Search the position of a ponder on its background thread
+ * @param arg The ponder (Ponder *)
+ * @return NULL
+ */
+static void * runPonder(void *arg) {
+
+    Ponder *ponder = (Ponder *) arg;
+
+    searchUntil(ponder->solver, &ponder->game, HUGE_VAL, &ponder->result);
+    return NULL;
+}
+
+/**
+ * @brief Start searching a position in the background while the opponent thinks
+ *
+ * The search runs without a deadline until `stopPonder`, or until its score
+ * is proven. Whatever it stored in the search table is reused by the next
+ * search of the solver, whichever reply the opponent chooses.
+ *
+ * @param ponder The ponder to start
+ * @param solver The solver, no other search may use it until `stopPonder`
+ * @param game The game with the opponent to move, copied
+ * @return 1 if the search started, 0 otherwise
+ */
+int startPonder(Ponder *ponder, Solver *solver, const Game *game) {
+
+    ponder->solver = solver;
+    ponder->game = *game;
+    ponder->running = 0;
+    memset(&ponder->result, 0, sizeof(SearchResult));
+    ponder->result.bestMove = NO_MOVE;
+
+    if (NUM_PLAYERS != 2) {
+        return 0;
+    }
+
+    // Cleared before the thread exists, so an early stopPonder is never lost
+    atomic_store(&solver->stop, 0);
+    if (pthread_create(&ponder->thread, NULL, runPonder, ponder) != 0) {
+        return 0;
+    }
+
+    ponder->running = 1;
+    return 1;
+}
+
+/**
+ * @brief Cancel a background search and wait for it to unwind
+ *
+ * The result of the ponder then holds its last completed iteration.
+ *
+ * @param ponder The ponder, may have failed to start
+ */
+void stopPonder(Ponder *ponder) {
+
+    if (!ponder->running) {
+        return;
+    }
+
+    atomic_store(&ponder->solver->stop, 1);
+    pthread_join(ponder->thread, NULL);
+    ponder->running = 0;
+}
@@ -0,0 +1,121 @@
+/**
+ * @file solver.h
+ * @brief Header file for solver.c
+ *
+ * Scores follow the usual convention: 0 is a draw, a positive score means
+ * the player to move wins, and its size grows the sooner the win comes
+ * (a win with the player's last disk scores 1). Negative scores are losses.
+ * Only two-player games are solved.
+ *
+ * A solve can run on several threads (Lazy SMP): every thread searches the
+ * same root with a slightly different move order and all of them share one
+ * lock-free transposition table. The first thread to finish gives the answer.
+ *
+ * An anytime search (`searchDeadline`) plays within a wall-clock budget
+ * instead: it deepens a depth-limited search one ply at a time, scoring the
+ * positions at the horizon by their threats, and answers with the best move
+ * of the last iteration that completed before the deadline. Its scores are
+ * exact scores times SEARCH_SCALE; heuristic scores stay strictly between
+ * -SEARCH_SCALE and SEARCH_SCALE. A ponder runs the same search in the
+ * background on the opponent's turn, until it is cancelled, so the search
+ * table already holds the position after their move when it is needed.
+ */
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stdatomic.h>
+#include <pthread.h>
+#include "book.h"
+#include "tablebase.h"
+#include "util.h"
+
+#define TT_BITS 23                       // log2 of the number of transposition table entries
+#define TT_SIZE ((size_t) 1 << TT_BITS)
+#define MIN_SCORE (-(geometry.cells + 2) / 2)   // Lower bound of any score or search window
+#define MAX_SCORE ((geometry.cells + 1) / 2)    // Upper bound of any score or search window
+#define NO_MOVE -1
+#define SEARCH_TT_BITS 20                // log2 of the entries of the depth-limited search table
+#define SEARCH_TT_SIZE ((size_t) 1 << SEARCH_TT_BITS)
+#define SEARCH_SCALE 64                  // Anytime score of an exact score of 1
+#define SEARCH_CLOCK_INTERVAL 256        // Nodes between two deadline checks of a search thread
+#define BOUND_LOWER 1                    // Kinds of score kept in the search table
+#define BOUND_UPPER 2
+#define BOUND_EXACT 3
+
+typedef struct TableEntry {
+    _Atomic uint64_t check;   // Folded position key XOR value, detects torn or foreign entries
+    _Atomic uint64_t value;   // Upper bound of the score, shifted so 0 marks an empty entry
+} TableEntry;
+
+typedef struct Solver {
+    TableEntry *table;        // Transposition table shared by every search thread
+    TableEntry *searchTable;  // Bounds of the depth-limited anytime search, kept between moves
+    const OpeningBook *book;  // Solved early positions, may be NULL
+    const Tablebase *tablebase; // Every solved position of a small board, may be NULL
+    int threads;              // Number of search threads
+    atomic_int stop;          // Set once one thread finished, the others give up
+    atomic_int done;          // Set by the first thread that finished
+    int score;                // Score found by the first thread that finished
+    unsigned long long nodes; // Positions visited by the last solve, all threads
+    double deadline;          // Time the anytime search stops at
+    atomic_ullong searchNodes; // Nodes of the anytime search, added up at every deadline check
+} Solver;
+
+typedef struct SearchWorker {
+    Solver *solver;
+    Game game;                // Private copy of the position being searched
+    int id;                   // Thread index, 0 is the calling thread
+    int aborted;              // Set when the search was stopped midway
+    uint64_t random;          // Tie-breaking state for the move ordering of helpers
+    unsigned long long nodes; // Positions visited by this thread
+} SearchWorker;
+
+typedef struct SolveResult {
+    int score;                // Game-theoretic score for the player to move
+    int bestMove;             // Column to play, NO_MOVE if the game is over
+    unsigned long long nodes; // Positions visited
+    double seconds;           // Wall-clock time of the solve
+} SolveResult;
+
+typedef struct SearchIteration {
+    int depth;                // Plies searched
+    int score;                // Anytime score of the best move, see SEARCH_SCALE
+    int bestMove;             // Best column at this depth
+    unsigned long long nodes; // Positions visited so far, all threads
+    double seconds;           // Time since the search started
+} SearchIteration;
+
+typedef struct SearchResult {
+    int bestMove;             // Best column of the last completed iteration, NO_MOVE if the game is over
+    int score;                // Its anytime score
+    int depth;                // Depth of the last completed iteration, 0 if none completed
+    int exact;                // Set if the score is proven, the search then stops early
+    int iterationCount;       // Completed iterations
+    SearchIteration iterations[MAX_MOVES + 1];
+    unsigned long long nodes; // Positions visited, all threads
+    double seconds;           // Wall-clock time of the search
+} SearchResult;
+
+typedef struct Ponder {
+    Solver *solver;           // Solver searching in the background
+    Game game;                // Position searched, the opponent to move
+    pthread_t thread;         // Background search thread
+    int running;              // Set while the thread may still be searching
+    SearchResult result;      // Last completed iteration once stopped
+} Ponder;
+
+Solver * makeSolver(void);
+void freeSolver(Solver *solver);
+void resetSolver(Solver *solver);
+void setSolverThreads(Solver *solver, int threads);
+void setSolverBook(Solver *solver, const OpeningBook *book);
+void setSolverTablebase(Solver *solver, const Tablebase *tablebase);
+int solveGame(Solver *solver, const Game *game, SolveResult *result);
+int solveBoard(Solver *solver, const char board[MAX_ROWS][MAX_COLS], SolveResult *result);
+int solveCode(Solver *solver, const char *code, SolveResult *result);
+int searchDeadline(Solver *solver, const Game *game, double seconds, SearchResult *result);
+int startPonder(Ponder *ponder, Solver *solver, const Game *game);
+void stopPonder(Ponder *ponder);
+double getTime(void);
+
+#endif
@@ -0,0 +1,780 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "tablebase.h"
+#include "bookBuilder.h"
+#include "record.h"
+
+typedef struct MappedFile {
+    void *map;               // The mapping, NULL for an empty file
+    size_t size;             // Size of the file in bytes
+} MappedFile;
+
+typedef struct ExpandWorker {
+    const PositionKey *parents;  // Slice of the ply to expand
+    size_t count;
+    PositionKey *children;       // Room for `count * columns` keys, sorted and unique once done
+    size_t size;                 // Number of children kept
+} ExpandWorker;
+
+typedef struct MergeSource {
+    const PositionKey *keys;     // A sorted list of keys
+    size_t count;
+    size_t next;                 // Index of the first key not merged yet
+} MergeSource;
+
+typedef struct TablebasePool {
+    const PositionKey *keys;         // The ply being scored or checked
+    size_t count;
+    const PositionKey *childKeys;    // The ply below it and its scores
+    const int8_t *childScores;
+    size_t childCount;
+    int8_t *scores;                  // Scores of `keys`, filled
+    const Tablebase *tablebase;      // Tablebase being checked
+    atomic_ullong invalid;           // Positions found invalid by the check
+    atomic_int next;                 // Index of the next batch
+} TablebasePool;
+
+/**
+ * @brief Make the name of a temporary file of a build
+ *
+ * @param name Buffer of FILENAME_MAX characters
+ * @param path Path of the tablebase
+ * @param kind "ply", "scores" or "run"
+ * @param index Ply or run number
+ * @return 1 on success, 0 if the name is too long
+ */
+static int getTempName(char *name, const char *path, const char *kind, int index) {
+    int length = snprintf(name, FILENAME_MAX, "%s.%s%d", path, kind, index);
+    return length > 0 && length < FILENAME_MAX;
+}
+
+/**
+ * @brief Map a whole file
+ *
+ * @param name Path of the file
+ * @param size Size of the file in bytes, 0 if it cannot be mapped
+ * @param writable Map it for writing instead of reading
+ * @return The mapping, NULL if the file is empty or cannot be mapped
+ */
+static void * mapFile(const char *name, size_t *size, int writable) {
+
+    int fd = open(name, writable ? O_RDWR : O_RDONLY);
+    struct stat info;
+    void *map = NULL;
+
+    *size = 0;
+    if (fd < 0) {
+        return NULL;
+    }
+
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        map = mmap(NULL, (size_t) info.st_size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) {
+            map = NULL;
+        } else {
+            *size = (size_t) info.st_size;
+        }
+    }
+
+    close(fd); // The mapping stays valid without the descriptor
+    return map;
+}
+
+/**
+ * @brief Create a file of a given size and map it for writing
+ *
+ * The file starts out as zeros and takes no disk space until written.
+ *
+ * @param name Path of the file, replaced if it exists
+ * @param size Size of the file in bytes
+ * @param file The mapping, filled
+ * @return 1 on success, 0 on failure
+ */
+static int createMappedFile(const char *name, size_t size, MappedFile *file) {
+
+    int fd = open(name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+    file->map = NULL;
+    file->size = 0;
+    if (fd < 0) {
+        return 0;
+    }
+    if (size == 0) {
+        close(fd);
+        return 1;
+    }
+
+    if (ftruncate(fd, (off_t) size) == 0) {
+        file->map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (file->map == MAP_FAILED) {
+            file->map = NULL;
+        } else {
+            file->size = size;
+        }
+    }
+
+    close(fd);
+    return file->map != NULL;
+}
+
+/**
+ * @brief Unmap a file mapped by `mapFile` or `createMappedFile`
+ * @param map The mapping, may be NULL
+ * @param size Size of the mapping in bytes
+ */
+static void unmapFile(void *map, size_t size) {
+    if (map != NULL) {
+        munmap(map, size);
+    }
+}
+
+/**
+ * @brief Collect, sort and deduplicate the children of a slice of a ply
+ *
+ * Children where the game is over are left out; their score is known
+ * without a lookup.
+ *
+ * @param arg The ExpandWorker of the thread
+ * @return NULL
+ */
+static void * runExpandWorker(void *arg) {
+
+    ExpandWorker *worker = (ExpandWorker *) arg;
+    size_t size = 0;
+
+    for (size_t i = 0; i < worker->count; i++) {
+        Game game;
+        loadGameFromKey(&game, worker->parents[i]);
+
+        for (int col = 0; col < geometry.columns; col++) {
+            if (!canPlay(&game, col)) {
+                continue;
+            }
+
+            int player = getCurrentPlayer(&game);
+            gameMakeMove(&game, col);
+            if (!hasConnect(game.disks[player], geometry.connect) && game.moves < geometry.cells) {
+                worker->children[size++] = getCanonicalKey(&game);
+            }
+            gameUnmakeMove(&game);
+        }
+    }
+
+    // Sort and drop the duplicates reached through different move orders
+    qsort(worker->children, size, sizeof(PositionKey), compareKeys);
+    worker->size = 0;
+    for (size_t i = 0; i < size; i++) {
+        if (worker->size == 0 || worker->children[worker->size - 1] != worker->children[i]) {
+            worker->children[worker->size++] = worker->children[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Restore the heap order of the merge sources below an entry
+ *
+ * @param sources The merge sources
+ * @param heap Source indices, the source with the smallest next key first
+ * @param size Number of entries in the heap
+ * @param entry The entry that may be out of place
+ */
+static void siftDown(const MergeSource *sources, int *heap, int size, int entry) {
+
+    for (;;) {
+        int smallest = entry;
+
+        for (int child = 2 * entry + 1; child <= 2 * entry + 2 && child < size; child++) {
+            const MergeSource *a = &sources[heap[child]];
+            const MergeSource *b = &sources[heap[smallest]];
+            if (a->keys[a->next] < b->keys[b->next]) {
+                smallest = child;
+            }
+        }
+        if (smallest == entry) {
+            return;
+        }
+
+        int swap = heap[entry];
+        heap[entry] = heap[smallest];
+        heap[smallest] = swap;
+        entry = smallest;
+    }
+}
+
+/**
+ * @brief Merge sorted key lists into a file, dropping duplicates
+ *
+ * @param sources The lists, advanced to their end
+ * @param count Number of lists
+ * @param output The file to append the keys to
+ * @param written Number of keys written
+ * @return 1 on success, 0 if memory ran out or a write failed
+ */
+static int mergeKeys(MergeSource *sources, int count, FILE *output, size_t *written) {
+
+    int *heap = (int *) malloc((count + 1) * sizeof(int));
+    int size = 0;
+    int ok = heap != NULL;
+
+    *written = 0;
+    for (int i = 0; ok && i < count; i++) {
+        if (sources[i].next < sources[i].count) {
+            heap[size++] = i;
+        }
+    }
+    for (int i = size / 2 - 1; i >= 0; i--) {
+        siftDown(sources, heap, size, i);
+    }
+
+    PositionKey last = 0; // No position has key 0
+    while (ok && size > 0) {
+        MergeSource *source = &sources[heap[0]];
+        PositionKey key = source->keys[source->next++];
+
+        if (key != last) {
+            ok = fwrite(&key, sizeof(PositionKey), 1, output) == 1;
+            last = key;
+            (*written)++;
+        }
+
+        // Drop an exhausted list, then put the smallest key back on top
+        if (source->next == source->count) {
+            heap[0] = heap[--size];
+        }
+        siftDown(sources, heap, size, 0);
+    }
+
+    free(heap);
+    return ok;
+}
+
+/**
+ * @brief Write the sorted keys of a ply's next ply to a file
+ *
+ * The ply is expanded in chunks that fit in `memory` bytes. Every chunk is
+ * split between the threads, which sort their part; the parts are merged
+ * into one sorted run per chunk and the runs into the file of the next ply.
+ * A ply that fits in memory is written as a single run and never merged
+ * again.
+ *
+ * @param path Path of the tablebase, the base name of the temporary files
+ * @param ply The ply to expand, its file must exist
+ * @param threads Number of threads
+ * @param memory Bytes of working memory
+ * @param stats The number of positions of the next ply and of runs, updated
+ * @return 1 on success, 0 if memory ran out or a file could not be written
+ */
+static int expandPly(const char *path, int ply, int threads, size_t memory, TablebaseStats *stats) {
+
+    char name[FILENAME_MAX];
+    char output[FILENAME_MAX];
+    ExpandWorker workers[MAX_THREADS];
+    pthread_t ids[MAX_THREADS];
+    MappedFile parents;
+    int runs = 0;
+    int ok = getTempName(name, path, "ply", ply) && getTempName(output, path, "ply", ply + 1);
+
+    if (!ok) {
+        return 0;
+    }
+    parents.map = mapFile(name, &parents.size, 0);
+    size_t count = parents.size / sizeof(PositionKey);
+
+    // Every parent of a chunk may have a child in every column
+    size_t perChunk = memory / sizeof(PositionKey) / geometry.columns;
+    if (perChunk > count) {
+        perChunk = count;
+    }
+    PositionKey *buffer = (PositionKey *) malloc((perChunk * geometry.columns + 1) * sizeof(PositionKey));
+    ok = buffer != NULL && (perChunk > 0 || count == 0);
+
+    for (size_t first = 0; ok && first < count; first += perChunk) {
+        size_t chunk = count - first < perChunk ? count - first : perChunk;
+        size_t slice = (chunk + threads - 1) / threads;
+
+        for (int t = 0; t < threads; t++) {
+            size_t start = t * slice < chunk ? t * slice : chunk;
+            workers[t].parents = (const PositionKey *) parents.map + first + start;
+            workers[t].count = chunk - start < slice ? chunk - start : slice;
+            workers[t].children = buffer + start * geometry.columns;
+            workers[t].size = 0;
+        }
+
+        // Start the helpers, then expand on the calling thread too
+        int started = startHelpers(ids, threads, runExpandWorker, workers, sizeof(workers[0]));
+        for (int t = started; t < threads; t++) {
+            runExpandWorker(&workers[t]); // Slices of the threads that could not start
+        }
+        runExpandWorker(&workers[0]);
+        joinHelpers(ids, started);
+
+        // Merge the slices into the run of this chunk
+        MergeSource sources[MAX_THREADS];
+        for (int t = 0; t < threads; t++) {
+            sources[t].keys = workers[t].children;
+            sources[t].count = workers[t].size;
+            sources[t].next = 0;
+        }
+
+        size_t written;
+        FILE *run = getTempName(name, path, "run", runs) ? fopen(name, "wb") : NULL;
+        ok = run != NULL && mergeKeys(sources, threads, run, &written);
+        ok = run != NULL && fclose(run) == 0 && ok;
+        runs++;
+    }
+
+    free(buffer);
+    unmapFile(parents.map, parents.size);
+
+    if (ok && runs <= 1) {
+        // A single run is already the next ply
+        if (runs == 1) {
+            ok = getTempName(name, path, "run", 0) && rename(name, output) == 0;
+        } else {
+            FILE *empty = fopen(output, "wb");
+            ok = empty != NULL && fclose(empty) == 0;
+        }
+    } else if (ok) {
+        // Merge the runs straight from their mappings
+        MappedFile *maps = (MappedFile *) calloc(runs, sizeof(MappedFile));
+        MergeSource *sources = (MergeSource *) calloc(runs, sizeof(MergeSource));
+        FILE *file = fopen(output, "wb");
+        size_t written;
+
+        ok = maps != NULL && sources != NULL && file != NULL;
+        for (int r = 0; ok && r < runs; r++) {
+            ok = getTempName(name, path, "run", r);
+            maps[r].map = mapFile(name, &maps[r].size, 0);
+            sources[r].keys = (const PositionKey *) maps[r].map;
+            sources[r].count = maps[r].size / sizeof(PositionKey);
+        }
+        ok = ok && mergeKeys(sources, runs, file, &written);
+        ok = file != NULL && fclose(file) == 0 && ok;
+
+        for (int r = 0; maps != NULL && r < runs; r++) {
+            unmapFile(maps[r].map, maps[r].size);
+        }
+        free(maps);
+        free(sources);
+        stats->runs += runs;
+    }
+
+    for (int r = 0; r < runs; r++) {
+        if (getTempName(name, path, "run", r)) {
+            unlink(name);
+        }
+    }
+
+    if (ok) {
+        struct stat info;
+        ok = stat(output, &info) == 0;
+        stats->counts[ply + 1] = ok ? (size_t) info.st_size / sizeof(PositionKey) : 0;
+    }
+    return ok;
+}
+
+/**
+ * @brief Score batches of positions until none are left
+ * @param arg The TablebasePool
+ * @return NULL
+ */
+static void * runScoreWorker(void *arg) {
+
+    TablebasePool *pool = (TablebasePool *) arg;
+
+    for (size_t first = (size_t) atomic_fetch_add(&pool->next, 1) * TABLEBASE_BATCH; first < pool->count;
+         first = (size_t) atomic_fetch_add(&pool->next, 1) * TABLEBASE_BATCH) {
+        size_t last = first + TABLEBASE_BATCH < pool->count ? first + TABLEBASE_BATCH : pool->count;
+
+        for (size_t i = first; i < last; i++) {
+            pool->scores[i] = (int8_t) scoreFromChildren(pool->keys[i], pool->childKeys, pool->childScores,
+                                                         pool->childCount);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Run a pool on the calling thread and `threads - 1` helpers
+ *
+ * @param work The function every thread runs
+ * @param pool The pool shared by the threads
+ * @param threads Number of threads
+ */
+static void runPool(ThreadWork work, TablebasePool *pool, int threads) {
+
+    atomic_init(&pool->next, 0);
+    runThreads(threads, work, pool, 0);
+}
+
+/**
+ * @brief Score every position of a ply from the scores of the next ply
+ *
+ * @param path Path of the tablebase, the base name of the temporary files
+ * @param ply The ply to score; its keys and the next ply's keys and scores must exist
+ * @param threads Number of threads
+ * @param count Number of positions of the ply
+ * @return 1 on success, 0 if a file could not be read or written
+ */
+static int scorePly(const char *path, int ply, int threads, size_t count) {
+
+    char name[FILENAME_MAX];
+    MappedFile keys;
+    MappedFile childKeys;
+    MappedFile childScores;
+    MappedFile scores;
+    TablebasePool pool;
+
+    keys.map = getTempName(name, path, "ply", ply) ? mapFile(name, &keys.size, 0) : NULL;
+    childKeys.map = getTempName(name, path, "ply", ply + 1) ? mapFile(name, &childKeys.size, 0) : NULL;
+    childScores.map = getTempName(name, path, "scores", ply + 1) ? mapFile(name, &childScores.size, 0) : NULL;
+    int ok = getTempName(name, path, "scores", ply) && createMappedFile(name, count, &scores) &&
+             keys.size == count * sizeof(PositionKey);
+
+    if (ok) {
+        pool.keys = (const PositionKey *) keys.map;
+        pool.count = count;
+        pool.childKeys = (const PositionKey *) childKeys.map;
+        pool.childScores = (const int8_t *) childScores.map;
+        pool.childCount = childKeys.size / sizeof(PositionKey);
+        pool.scores = (int8_t *) scores.map;
+        runPool(runScoreWorker, &pool, threads);
+    }
+
+    unmapFile(keys.map, keys.size);
+    unmapFile(childKeys.map, childKeys.size);
+    unmapFile(childScores.map, childScores.size);
+    unmapFile(scores.map, scores.size);
+    return ok;
+}
+
+/**
+ * @brief Hash a position key to its home slot
+ *
+ * @param key The canonical position key
+ * @param slots Number of slots
+ * @return Index of the first slot to probe
+ */
+static uint64_t getHomeSlot(PositionKey key, uint64_t slots) {
+
+    uint64_t x = FOLD_KEY(key);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return (x ^ (x >> 31)) % slots;
+}
+
+/**
+ * @brief Move the scored positions of a ply into the table and delete its files
+ *
+ * @param path Path of the tablebase, the base name of the temporary files
+ * @param ply The ply
+ * @param table The mapped tablebase file
+ * @param stats The build statistics
+ * @return 1 on success, 0 if a file could not be read
+ */
+static int insertPly(const char *path, int ply, unsigned char *table, const TablebaseStats *stats) {
+
+    char keysName[FILENAME_MAX];
+    char scoresName[FILENAME_MAX];
+    const TablebaseHeader *header = (const TablebaseHeader *) table;
+    unsigned char *slots = table + sizeof(TablebaseHeader);
+    int slotSize = header->recordSize + 1;
+    MappedFile keys;
+    MappedFile scores;
+
+    if (!getTempName(keysName, path, "ply", ply) || !getTempName(scoresName, path, "scores", ply)) {
+        return 0;
+    }
+    keys.map = mapFile(keysName, &keys.size, 0);
+    scores.map = mapFile(scoresName, &scores.size, 0);
+    int ok = keys.size == stats->counts[ply] * sizeof(PositionKey) && scores.size == stats->counts[ply];
+
+    for (size_t i = 0; ok && i < stats->counts[ply]; i++) {
+        PositionKey key = ((const PositionKey *) keys.map)[i];
+        uint64_t slot = getHomeSlot(key, header->slots);
+
+        // Linear probing up to the first empty slot
+        while (loadRecord(slots + slot * slotSize) != 0) {
+            slot = slot + 1 == header->slots ? 0 : slot + 1;
+        }
+        storeRecord(key, slots + slot * slotSize);
+        slots[slot * slotSize + header->recordSize] = ((const unsigned char *) scores.map)[i];
+    }
+
+    unmapFile(keys.map, keys.size);
+    unmapFile(scores.map, scores.size);
+    unlink(keysName);
+    unlink(scoresName);
+    return ok;
+}
+
+/**
+ * @brief Build the tablebase of the current geometry by retrograde analysis
+ *
+ * The plies are enumerated from the empty board, each one written to a
+ * temporary file next to `path`, then scored from the last ply back to the
+ * first. A ply is moved into the table once the ply above it is scored, so
+ * at most three plies are on disk besides the table. Working memory stays
+ * within `memory` bytes plus the pages of the mapped files, which the
+ * system can drop at any time. Progress is reported on stderr.
+ *
+ * @param path Path of the tablebase file to write
+ * @param threads Number of threads
+ * @param memory Bytes of working memory for the enumeration
+ * @param stats The size of every ply and the score of the empty board
+ * @return 1 on success, 0 if memory ran out or a file could not be written
+ */
+int buildTablebase(const char *path, int threads, size_t memory, TablebaseStats *stats) {
+
+    char name[FILENAME_MAX];
+    double start = getTime();
+    int last = 0;
+    Game game;
+
+    memset(stats, 0, sizeof(TablebaseStats));
+    threads = threads < 1 ? 1 : threads > MAX_THREADS ? MAX_THREADS : threads;
+
+    // Start from the empty board
+    initGame(&game);
+    PositionKey root = getCanonicalKey(&game);
+    FILE *file = getTempName(name, path, "ply", 0) ? fopen(name, "wb") : NULL;
+    int ok = file != NULL && fwrite(&root, sizeof(root), 1, file) == 1;
+    ok = file != NULL && fclose(file) == 0 && ok;
+    stats->counts[0] = 1;
+
+    // Enumerate the plies while there are positions left
+    while (ok && last + 1 < geometry.cells) {
+        ok = expandPly(path, last, threads, memory, stats);
+        if (!ok || stats->counts[last + 1] == 0) {
+            break;
+        }
+        last++;
+        fprintf(stderr, "ply %d: %zu positions\n", last, stats->counts[last]);
+    }
+
+    for (int ply = 0; ply <= last; ply++) {
+        stats->count += stats->counts[ply];
+    }
+
+    // Size the table for the positions found
+    MappedFile table = {NULL, 0};
+    TablebaseHeader header;
+    memcpy(header.magic, TABLEBASE_MAGIC, 4);
+    header.version = TABLEBASE_VERSION;
+    header.rows = geometry.rows;
+    header.columns = geometry.columns;
+    header.connect = geometry.connect;
+    header.recordSize = getRecordSize();
+    header.slots = stats->count * 100 / TABLEBASE_LOAD + 1;
+    header.count = stats->count;
+
+    ok = ok && createMappedFile(path, sizeof(header) + header.slots * (header.recordSize + 1), &table);
+    if (ok) {
+        memcpy(table.map, &header, sizeof(header));
+    }
+
+    // Score from the last ply back, filing every ply once its parents are scored
+    for (int ply = last; ok && ply >= 0; ply--) {
+        ok = scorePly(path, ply, threads, stats->counts[ply]);
+        if (ok && ply < last) {
+            ok = insertPly(path, ply + 1, table.map, stats);
+        }
+        fprintf(stderr, "scored ply %d\n", ply);
+    }
+
+    if (ok) {
+        MappedFile scores;
+        scores.map = getTempName(name, path, "scores", 0) ? mapFile(name, &scores.size, 0) : NULL;
+        ok = scores.size == 1;
+        stats->score = ok ? *(const int8_t *) scores.map : 0;
+        unmapFile(scores.map, scores.size);
+        ok = ok && insertPly(path, 0, table.map, stats);
+    }
+
+    // Leave no temporary files behind, even after a failure
+    for (int ply = 0; ply <= last + 1 && ply < geometry.cells; ply++) {
+        if (getTempName(name, path, "ply", ply)) {
+            unlink(name);
+        }
+        if (getTempName(name, path, "scores", ply)) {
+            unlink(name);
+        }
+    }
+
+    if (table.map != NULL) {
+        ok = msync(table.map, table.size, MS_SYNC) == 0 && ok;
+        unmapFile(table.map, table.size);
+    }
+    if (!ok) {
+        unlink(path);
+    }
+
+    stats->seconds = getTime() - start;
+    return ok;
+}
+
+/**
+ * @brief Map a tablebase file into memory
+ *
+ * Only the header is checked; the slots are used in place. A tablebase
+ * must match the current geometry.
+ *
+ * @param path Path of the tablebase file
+ * @return The tablebase, or NULL if the file cannot be used with this board geometry
+ */
+Tablebase * openTablebase(const char *path) {
+
+    size_t size;
+    void *map = mapFile(path, &size, 0);
+
+    if (map == NULL) {
+        return NULL;
+    }
+
+    const TablebaseHeader *header = (const TablebaseHeader *) map;
+    int slotSize = getRecordSize() + 1;
+
+    // Reject tablebases of another format or board geometry; the slot count
+    // is bounded by the file before it is multiplied, so it cannot overflow
+    if (size < sizeof(TablebaseHeader) || memcmp(header->magic, TABLEBASE_MAGIC, 4) != 0 ||
+        header->version != TABLEBASE_VERSION || header->rows != geometry.rows ||
+        header->columns != geometry.columns || header->connect != geometry.connect ||
+        header->recordSize != getRecordSize() || header->slots <= header->count ||
+        header->slots > (size - sizeof(TablebaseHeader)) / slotSize ||
+        size != sizeof(TablebaseHeader) + header->slots * slotSize) {
+        munmap(map, size);
+        return NULL;
+    }
+
+    Tablebase *tablebase = (Tablebase *) malloc(sizeof(Tablebase));
+    if (tablebase == NULL) {
+        munmap(map, size);
+        return NULL;
+    }
+
+    // Lookups land anywhere in the table
+    posix_madvise(map, size, POSIX_MADV_RANDOM);
+
+    tablebase->map = map;
+    tablebase->size = size;
+    tablebase->recordSize = header->recordSize;
+    tablebase->slotSize = slotSize;
+    tablebase->slots = header->slots;
+    tablebase->count = header->count;
+    tablebase->table = (const unsigned char *) map + sizeof(TablebaseHeader);
+
+    return tablebase;
+}
+
+/**
+ * @brief Unmap and free a tablebase
+ * @param tablebase The tablebase, may be NULL
+ */
+void closeTablebase(Tablebase *tablebase) {
+
+    if (tablebase == NULL) {
+        return;
+    }
+
+    munmap(tablebase->map, tablebase->size);
+    free(tablebase);
+}
+
+/**
+ * @brief Look up the score of a position
+ *
+ * @param tablebase The tablebase
+ * @param game The game to look up
+ * @param score The stored score for the player to move, set when found
+ * @return 1 if the position is in the tablebase, 0 if it is not (or the game is over)
+ */
+int lookupTablebase(const Tablebase *tablebase, const Game *game, int *score) {
+
+    PositionKey key = getCanonicalKey(game);
+    uint64_t slot = getHomeSlot(key, tablebase->slots);
+
+    for (;;) {
+        const unsigned char *entry = tablebase->table + slot * tablebase->slotSize;
+        PositionKey stored = loadRecord(entry);
+
+        if (stored == key) {
+            *score = (int8_t) entry[tablebase->recordSize];
+            return 1;
+        }
+        if (stored == 0) {
+            return 0;
+        }
+        slot = slot + 1 == tablebase->slots ? 0 : slot + 1;
+    }
+}
+
+/**
+ * @brief Check batches of slots until none are left
+ * @param arg The TablebasePool
+ * @return NULL
+ */
+static void * runCheckWorker(void *arg) {
+
+    TablebasePool *pool = (TablebasePool *) arg;
+    const Tablebase *tablebase = pool->tablebase;
+    unsigned long long invalid = 0;
+
+    for (uint64_t first = (uint64_t) atomic_fetch_add(&pool->next, 1) * TABLEBASE_BATCH; first < tablebase->slots;
+         first = (uint64_t) atomic_fetch_add(&pool->next, 1) * TABLEBASE_BATCH) {
+        uint64_t last = first + TABLEBASE_BATCH < tablebase->slots ? first + TABLEBASE_BATCH : tablebase->slots;
+
+        for (uint64_t slot = first; slot < last; slot++) {
+            const unsigned char *entry = tablebase->table + slot * tablebase->slotSize;
+            PositionKey key = loadRecord(entry);
+            int score = (int8_t) entry[tablebase->recordSize];
+            char board[MAX_ROWS][MAX_COLS];
+
+            if (key == 0) {
+                continue; // Empty slot
+            }
+
+            // The board must be legal under the game's own rules and the game still on
+            if (keyToBoard(key, board) != VALID_BOARD ||
+                isValidBoard(board, geometry.rows, geometry.columns, NUM_PLAYERS, geometry.connect) != VALID_BOARD ||
+                getStatus(board, geometry.rows, geometry.columns, NUM_PLAYERS, geometry.connect) != GAME_ON ||
+                score < MIN_SCORE || score > MAX_SCORE) {
+                invalid++;
+            }
+        }
+    }
+
+    atomic_fetch_add(&pool->invalid, invalid);
+    return NULL;
+}
+
+/**
+ * @brief Check every stored position with `isValidBoard`
+ *
+ * A position passes if its board is legal, the game on it is still on and
+ * its score is within the bounds of the board.
+ *
+ * @param tablebase The tablebase
+ * @param threads Number of threads
+ * @param invalid Number of positions that failed
+ * @return 1 if every position passed, 0 otherwise
+ */
+int checkTablebase(const Tablebase *tablebase, int threads, uint64_t *invalid) {
+
+    TablebasePool pool;
+
+    pool.tablebase = tablebase;
+    atomic_init(&pool.invalid, 0);
+    runPool(runCheckWorker, &pool, threads < 1 ? 1 : threads > MAX_THREADS ? MAX_THREADS : threads);
+
+    *invalid = atomic_load(&pool.invalid);
+    return *invalid == 0;
+}
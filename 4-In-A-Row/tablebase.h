@@ -0,0 +1,64 @@
+/**
+ * @file tablebase.h
+ * @brief Header file for tablebase.c
+ *
+ * A tablebase holds the solved score of every reachable position of a
+ * small board in which the game is still on. It is built by retrograde
+ * analysis: the positions are enumerated ply by ply from the empty board,
+ * then scored from the last ply back to the first, every position from the
+ * scores of its children. A position and its mirror image share one slot.
+ *
+ * The file is a fixed header followed by an open-addressing hash table:
+ * every slot is a position record (see record.h) and a score byte, and an
+ * all-zero record marks an empty slot. A lookup hashes the key to its home
+ * slot and walks forward to the key or an empty slot, so it costs a few
+ * bytes of the mapped file whatever the size of the board.
+ */
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include <stddef.h>
+#include "game.h"
+
+#define TABLEBASE_MAGIC "C4TB"
+#define TABLEBASE_VERSION 1
+#define TABLEBASE_LOAD 80                 // Percent of the slots in use
+#define TABLEBASE_DEFAULT_MEMORY 1024     // Megabytes of working memory of a build
+#define TABLEBASE_BATCH 4096              // Positions handed to a thread at a time
+
+typedef struct TablebaseHeader {
+    char magic[4];       // TABLEBASE_MAGIC
+    uint32_t version;    // TABLEBASE_VERSION
+    int32_t rows;        // Board geometry the tablebase was built for
+    int32_t columns;
+    int32_t connect;
+    int32_t recordSize;  // Bytes of the position record of every slot
+    uint64_t slots;      // Number of slots
+    uint64_t count;      // Number of positions stored
+} TablebaseHeader;
+
+typedef struct Tablebase {
+    void *map;                   // The whole mapped file
+    size_t size;                 // Size of the mapping in bytes
+    int recordSize;              // Bytes of the position record of every slot
+    int slotSize;                // Bytes of every slot, record and score
+    uint64_t slots;              // Number of slots
+    uint64_t count;              // Number of positions stored
+    const unsigned char *table;  // The slots, back to back
+} Tablebase;
+
+typedef struct TablebaseStats {
+    size_t counts[MAX_MOVES + 1];  // Positions stored for every ply
+    uint64_t count;                // Positions stored, all plies
+    uint64_t runs;                 // Sorted runs written because a ply did not fit in memory
+    int score;                     // Score of the empty board
+    double seconds;                // Wall-clock time of the build
+} TablebaseStats;
+
+int buildTablebase(const char *path, int threads, size_t memory, TablebaseStats *stats);
+Tablebase * openTablebase(const char *path);
+void closeTablebase(Tablebase *tablebase);
+int lookupTablebase(const Tablebase *tablebase, const Game *game, int *score);
+int checkTablebase(const Tablebase *tablebase, int threads, uint64_t *invalid);
+
+#endif
@@ -0,0 +1,280 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdatomic.h>
+#include "tournament.h"
+#include "solver.h"
+
+typedef struct TournamentPool {
+    const Engine *engines;   // The two engines
+    GameRecord *records;     // One record per game
+    int games;               // Number of games
+    uint64_t seed;           // Tournament seed
+    atomic_int next;         // Index of the next game to play
+    atomic_int failed;       // Set if a game could not be played
+} TournamentPool;
+
+/**
+ * @brief Read an engine specification
+ *
+ * "random" plays random columns; "mcts:<budget>" and
+ * "mcts:<budget>:<exploration>" run MCTS with a budget of playouts or a
+ * time such as "20ms".
+ *
+ * @param spec The specification
+ * @param engine The engine to fill
+ * @return 1 on success, 0 if the specification is not understood
+ */
+int parseEngine(const char *spec, Engine *engine) {
+
+    const char *MCTS_PREFIX = "mcts:";
+    char *end;
+
+    if (strlen(spec) >= ENGINE_NAME_LENGTH) {
+        return 0;
+    }
+    strcpy(engine->name, spec);
+    initMctsConfig(&engine->mcts);
+
+    if (strcmp(spec, "random") == 0) {
+        engine->type = ENGINE_RANDOM;
+        return 1;
+    }
+    if (strncmp(spec, MCTS_PREFIX, strlen(MCTS_PREFIX)) != 0) {
+        return 0;
+    }
+
+    engine->type = ENGINE_MCTS;
+    long amount = strtol(spec + strlen(MCTS_PREFIX), &end, 10);
+    if (amount <= 0) {
+        return 0;
+    }
+
+    // A bare number counts playouts, a number with "ms" is a time limit
+    if (strncmp(end, "ms", 2) == 0) {
+        engine->mcts.milliseconds = (int) amount;
+        end += 2;
+    } else {
+        engine->mcts.playouts = amount;
+    }
+
+    if (*end == ':') {
+        engine->mcts.exploration = strtod(end + 1, &end);
+    }
+    return *end == '\0' && engine->mcts.exploration >= 0;
+}
+
+/**
+ * @brief Let an engine choose the column to play
+ *
+ * @param engine The engine
+ * @param game The game, nobody may have won yet
+ * @param seed Seed of the engine's random choices
+ * @return The column, NO_MOVE if the engine failed
+ */
+int chooseEngineMove(const Engine *engine, const Game *game, uint64_t seed) {
+
+    if (engine->type == ENGINE_RANDOM) {
+        int columns[MAX_COLS];
+        int count = 0;
+
+        for (int col = 0; col < geometry.columns; col++) {
+            if (canPlay(game, col)) {
+                columns[count++] = col;
+            }
+        }
+        return count > 0 ? columns[seed % count] : NO_MOVE;
+    }
+
+    // Callers run many games at once, so each search runs on one thread
+    MctsConfig config = engine->mcts;
+    MctsResult result;
+    config.threads = 1;
+    config.seed = seed;
+
+    return searchMcts(game, &config, &result) ? result.bestMove : NO_MOVE;
+}
+
+/**
+ * @brief Let an engine choose the column to play on a character board
+ *
+ * @param engine The engine
+ * @param board The board of the game
+ * @param random The random state of the game, advanced
+ * @return The column, NO_MOVE if the engine failed
+ */
+static int chooseMove(const Engine *engine, const char board[MAX_ROWS][MAX_COLS], uint64_t *random) {
+
+    Game game;
+    *random = mixSeed(*random);
+
+    if (!loadGame(&game, board, geometry.rows, geometry.columns)) {
+        return NO_MOVE;
+    }
+
+    return chooseEngineMove(engine, &game, *random);
+}
+
+/**
+ * @brief Play one game of the tournament
+ *
+ * @param engines The two engines
+ * @param index Index of the game, engine 0 moves first in even games
+ * @param seed Tournament seed
+ * @param record The record to fill
+ * @return 1 on success, 0 if an engine failed to move
+ */
+static int playTournamentGame(const Engine engines[2], int index, uint64_t seed, GameRecord *record) {
+
+    char board[MAX_ROWS][MAX_COLS];
+    uint64_t random = mixSeed(seed ^ mixSeed((uint64_t) index));
+    int status = GAME_ON;
+    int moves = 0;
+
+    initBoard(board, geometry.rows, geometry.columns);
+    memset(record, 0, sizeof(GameRecord));
+    record->first = index % 2;
+    record->winner = -1;
+
+    while (status == GAME_ON) {
+        int engine = (record->first + moves) % 2;
+        char player = 'A' + moves % NUM_PLAYERS;
+
+        double start = getTime();
+        int col = chooseMove(&engines[engine], board, &random);
+        record->seconds[engine] += getTime() - start;
+        record->turns[engine]++;
+
+        // Play through the same path as the interactive game
+        record->columns[moves] = (int8_t) col;
+        status = playMove(board, geometry.rows, geometry.columns, NUM_PLAYERS, geometry.connect, player, col, &moves);
+        if (status == MOVE_FAILED) {
+            return 0;
+        }
+        if (status == GAME_WON) {
+            record->winner = engine;
+        }
+    }
+
+    record->moves = moves;
+    return 1;
+}
+
+/**
+ * @brief Play games until none are left
+ * @param arg The TournamentPool
+ * @return NULL
+ */
+static void * runTournamentWorker(void *arg) {
+
+    TournamentPool *pool = (TournamentPool *) arg;
+
+    for (int game = atomic_fetch_add(&pool->next, 1); game < pool->games; game = atomic_fetch_add(&pool->next, 1)) {
+        if (!playTournamentGame(pool->engines, game, pool->seed, &pool->records[game])) {
+            atomic_store(&pool->failed, 1);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Get the Elo difference matching an expected score
+ * @param score Points per game, between 0 and 1
+ * @return The Elo difference, infinite for 0 or 1
+ */
+static double getEloDifference(double score) {
+
+    if (score <= 0) {
+        return -INFINITY;
+    }
+    if (score >= 1) {
+        return INFINITY;
+    }
+
+    return -400 * log10(1 / score - 1);
+}
+
+/**
+ * @brief Play a tournament between two engines
+ *
+ * The Elo interval comes from the standard error of the mean score per
+ * game, mapped through the Elo curve.
+ *
+ * @param engines The two engines
+ * @param games Number of games
+ * @param threads Number of games played at once
+ * @param seed Tournament seed
+ * @param records One record per game, filled in game order
+ * @param stats The results, from engine 0's point of view
+ * @return 1 on success, 0 if an engine failed to move
+ */
+int runTournament(const Engine engines[2], int games, int threads, uint64_t seed,
+                  GameRecord *records, TournamentStats *stats) {
+
+    TournamentPool pool;
+    double start = getTime();
+
+    pool.engines = engines;
+    pool.records = records;
+    pool.games = games;
+    pool.seed = seed;
+    atomic_init(&pool.next, 0);
+    atomic_init(&pool.failed, 0);
+
+    runThreads(threads, runTournamentWorker, &pool, 0);
+
+    memset(stats, 0, sizeof(TournamentStats));
+    stats->games = games;
+    stats->seconds = getTime() - start;
+
+    int turns[2] = {0, 0};
+    for (int i = 0; i < games; i++) {
+        stats->wins += records[i].winner == 0;
+        stats->losses += records[i].winner == 1;
+        stats->draws += records[i].winner < 0;
+
+        for (int engine = 0; engine < 2; engine++) {
+            stats->moveTime[engine] += records[i].seconds[engine];
+            turns[engine] += records[i].turns[engine];
+        }
+    }
+    for (int engine = 0; engine < 2; engine++) {
+        stats->moveTime[engine] = turns[engine] > 0 ? stats->moveTime[engine] / turns[engine] : 0;
+    }
+
+    if (games > 0) {
+        double score = (stats->wins + 0.5 * stats->draws) / games;
+        double variance = (stats->wins * (1 - score) * (1 - score) + stats->draws * (0.5 - score) * (0.5 - score) +
+                           stats->losses * score * score) / games;
+        double margin = ELO_CONFIDENCE * sqrt(variance / games);
+
+        stats->score = score;
+        stats->elo = getEloDifference(score);
+        stats->eloError = isinf(stats->elo) ? INFINITY :
+                          (getEloDifference(score + margin) - getEloDifference(score - margin)) / 2;
+    }
+
+    return !atomic_load(&pool.failed);
+}
+
+/**
+ * @brief Write a game as one line: index, engines, result and moves
+ *
+ * The moves are the 0-based columns, one digit per move.
+ *
+ * @param output The stream to write to
+ * @param index Index of the game
+ * @param record The game
+ * @param engines The two engines
+ */
+void writeGameRecord(FILE *output, int index, const GameRecord *record, const Engine engines[2]) {
+
+    const char *result = record->winner < 0 ? "1/2-1/2" : record->winner == record->first ? "1-0" : "0-1";
+
+    fprintf(output, "%d %s %s %s ", index, engines[record->first].name, engines[1 - record->first].name, result);
+    for (int i = 0; i < record->moves; i++) {
+        fputc('0' + record->columns[i], output);
+    }
+    fputc('\n', output);
+}
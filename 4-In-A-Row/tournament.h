@@ -0,0 +1,55 @@
+/**
+ * @file tournament.h
+ * @brief Header file for tournament.c
+ *
+ * Plays many games between two engines on a pool of threads. Games are
+ * played on a character board through `playMove`, the same path as the
+ * interactive game, and the engines think on a Game loaded from it. Engine
+ * 0 moves first in even games and engine 1 in odd games. Every game has its
+ * own seed derived from the tournament seed and its index, so a tournament
+ * with playout budgets is replayed exactly whatever the number of threads.
+ */
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+
+#include "mcts.h"
+
+#define ENGINE_RANDOM 0          // Plays a uniformly random column
+#define ENGINE_MCTS 1            // Monte Carlo Tree Search on one thread
+#define ENGINE_NAME_LENGTH 32
+#define ELO_CONFIDENCE 1.96      // Normal quantile of the 95% Elo interval
+
+typedef struct Engine {
+    int type;                        // ENGINE_RANDOM or ENGINE_MCTS
+    MctsConfig mcts;                 // Budget and settings of an MCTS engine
+    char name[ENGINE_NAME_LENGTH];   // The specification it was parsed from
+} Engine;
+
+typedef struct GameRecord {
+    int first;                   // Engine that moved first, 0 or 1
+    int winner;                  // Engine that won, -1 for a draw
+    int moves;                   // Number of moves played
+    int8_t columns[MAX_MOVES];   // Column of every move, from the first
+    double seconds[2];           // Thinking time of each engine
+    int turns[2];                // Moves made by each engine
+} GameRecord;
+
+typedef struct TournamentStats {
+    int games;                   // Games played
+    int wins;                    // Results from engine 0's point of view
+    int draws;
+    int losses;
+    double score;                // Points per game of engine 0, a draw is half a point
+    double elo;                  // Elo difference of engine 0 over engine 1
+    double eloError;             // Half-width of the 95% interval of `elo`
+    double moveTime[2];          // Average thinking time per move of each engine
+    double seconds;              // Wall-clock time of the tournament
+} TournamentStats;
+
+int parseEngine(const char *spec, Engine *engine);
+int chooseEngineMove(const Engine *engine, const Game *game, uint64_t seed);
+int runTournament(const Engine engines[2], int games, int threads, uint64_t seed,
+                  GameRecord *records, TournamentStats *stats);
+void writeGameRecord(FILE *output, int index, const GameRecord *record, const Engine engines[2]);
+
+#endif
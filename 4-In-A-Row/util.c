@@ -0,0 +1,97 @@
+#include "util.h"
+#include "game.h"
+
+/**
+ * @brief Mix a number into a well-spread 64-bit value (splitmix64)
+ *
+ * Turns a seed and an index into an independent starting state, so that a
+ * game or a board depends on its index only and not on the thread that
+ * handles it.
+ *
+ * @param x The number
+ * @return The mixed value
+ */
+uint64_t mixSeed(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief Compare two position keys for qsort
+ * @param a Pointer to the first key
+ * @param b Pointer to the second key
+ * @return Negative, zero or positive as with strcmp
+ */
+int compareKeys(const void *a, const void *b) {
+    PositionKey x = *(const PositionKey *) a;
+    PositionKey y = *(const PositionKey *) b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Start the helpers of a pool; the calling thread is thread 0
+ *
+ * Helper i runs `work` on the argument at `args + i * stride`, so a stride
+ * of 0 hands every thread the same argument. Starting stops at the first
+ * helper that cannot be created.
+ *
+ * @param ids Filled with the helper of every thread from 1 on
+ * @param threads Number of threads wanted, the calling thread included
+ * @param work The function every thread runs
+ * @param args Argument of thread 0
+ * @param stride Bytes between the arguments of two threads
+ * @return Number of threads working, the calling thread included
+ */
+int startHelpers(pthread_t ids[], int threads, ThreadWork work, void *args, size_t stride) {
+
+    int started = 1;
+
+    for (; started < threads; started++) {
+        if (pthread_create(&ids[started], NULL, work, (char *) args + started * stride) != 0) {
+            break; // Carry on with the threads we have
+        }
+    }
+
+    return started;
+}
+
+/**
+ * @brief Wait for the helpers started by `startHelpers`
+ * @param ids The helpers
+ * @param started Number of threads returned by `startHelpers`
+ */
+void joinHelpers(const pthread_t ids[], int started) {
+
+    for (int i = 1; i < started; i++) {
+        pthread_join(ids[i], NULL);
+    }
+}
+
+/**
+ * @brief Run a pool: start the helpers, work on the calling thread too, then wait
+ *
+ * @param threads Number of threads wanted, clamped to 1..MAX_THREADS
+ * @param work The function every thread runs
+ * @param args Argument of thread 0
+ * @param stride Bytes between the arguments of two threads, 0 to share one argument
+ * @return Number of threads that worked, the calling thread included
+ */
+int runThreads(int threads, ThreadWork work, void *args, size_t stride) {
+
+    pthread_t ids[MAX_THREADS];
+
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > MAX_THREADS) {
+        threads = MAX_THREADS;
+    }
+
+    int started = startHelpers(ids, threads, work, args, stride);
+    work(args);
+    joinHelpers(ids, started);
+
+    return started;
+}
@@ -0,0 +1,44 @@
+/**
+ * @file util.h
+ * @brief Header file for util.c
+ *
+ * Small helpers shared by the engines and the analysis tools: the
+ * pseudo-random generators of the playouts and seeds, the ordering of
+ * position keys used to sort and deduplicate them, and the way work is
+ * spread over threads. A pool is the calling thread and up to
+ * `threads - 1` helpers; a helper that cannot be started is skipped, and
+ * the threads that did start share the work.
+ */
+#ifndef UTIL_H
+#define UTIL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#define MAX_THREADS 256
+
+typedef void * (*ThreadWork)(void *arg); // Work of one thread of a pool, as for pthread_create
+
+/**
+ * @brief Draw the next pseudo-random number (xorshift64*)
+ *
+ * Defined here so that playout loops can inline it.
+ *
+ * @param state The generator state, never 0
+ * @return A 64-bit pseudo-random number
+ */
+static inline uint64_t nextRandom(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+uint64_t mixSeed(uint64_t x);
+int compareKeys(const void *a, const void *b);
+int startHelpers(pthread_t ids[], int threads, ThreadWork work, void *args, size_t stride);
+void joinHelpers(const pthread_t ids[], int started);
+int runThreads(int threads, ThreadWork work, void *args, size_t stride);
+
+#endif